@@ -47,10 +47,31 @@ int main(int argc, char *argv[]) {
 Application::Application(char *infile) {
 	int i;
 	par = new Params();
-	srand (time(NULL));
 	par->setparams(infile);
+	if ( par->SEED == 0 ) {
+		par->SEED = time(NULL);
+	}
+	srand(par->SEED);
 	log = new Log(par);
-	en = new EmulNet(par);
+	if ( par->TRANSPORT != EMULNET_TRANSPORT && par->THREADS > 1 ) {
+		cout << "THREADS needs the EmulNet transport, stepping nodes serially" << endl;
+		par->THREADS = 1;
+	}
+	if ( par->SIM_ENGINE && par->TRANSPORT != EMULNET_TRANSPORT ) {
+		cout << "SIM_ENGINE needs the EmulNet transport, stepping every time unit" << endl;
+		par->SIM_ENGINE = 0;
+	}
+	if ( !par->SIM_ENGINE && (par->LATENCY != 1 || par->ZONES > 1 || par->RACKS_PER_ZONE > 1 || par->JITTER > 0 || par->EGRESS_BYTES > 0) ) {
+		cout << "The link model needs SIM_ENGINE: 1, delivering every message in the next time unit" << endl;
+	}
+	if ( par->SIM_ENGINE && par->THREADS > 1 ) {
+		cout << "SIM_ENGINE steps nodes serially, ignoring THREADS" << endl;
+		par->THREADS = 1;
+	}
+	en = Transport::create(par);
+	workers = par->THREADS > 1 ? new ThreadPool(par->THREADS) : NULL;
+	worker = 0;
+	processes = 1;
 	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
 
 	/*
@@ -73,6 +94,7 @@ Application::Application(char *infile) {
  * Destructor
  */
 Application::~Application() {
+	delete workers;
 	delete log;
 	delete en;
 	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
@@ -93,14 +115,51 @@ int Application::run()
 	int timeWhenAllNodesHaveJoined = 0;
 	// boolean indicating if all nodes have joined
 	bool allNodesJoined = false;
-	srand(time(NULL));
+	// wall-clock time spent simulating, in total and in the slowest tick
+	double wallSeconds = 0, maxTickSeconds = 0;
+	srand(par->SEED);
+
+	// With the shared-memory transport, worker processes run the time loop
+	if ( par->TRANSPORT == SHM_TRANSPORT ) {
+		timeWhenAllNodesHaveJoined = runWorkers((ShmNet *)en, &wallSeconds, &maxTickSeconds);
+		allNodesJoined = timeWhenAllNodesHaveJoined >= 0;
+	}
+	// With the event engine, time jumps from one event to the next
+	else if ( par->SIM_ENGINE ) {
+		timeWhenAllNodesHaveJoined = runEvents((EmulNet *)en, &wallSeconds, &maxTickSeconds);
+		allNodesJoined = timeWhenAllNodesHaveJoined >= 0;
+	}
 
 	// As time runs along
-	for( par->globaltime = 0; par->globaltime < TOTAL_RUNNING_TIME; ++par->globaltime ) {
+	for( par->globaltime = (par->TRANSPORT == SHM_TRANSPORT || par->SIM_ENGINE) ? par->TOTAL_RUNNING_TIME : 0; par->globaltime < par->TOTAL_RUNNING_TIME; ++par->globaltime ) {
+		chrono::steady_clock::time_point tickStart = chrono::steady_clock::now();
 		// Run the membership protocol
 		mp1Run();
+		double tickSeconds = chrono::duration<double>(chrono::steady_clock::now() - tickStart).count();
+		// Record when every node first knows every other node
+		if ( !allNodesJoined && allNodesHaveFullMembership() ) {
+			allNodesJoined = true;
+			timeWhenAllNodesHaveJoined = par->getcurrtime();
+		}
 		// Fail some nodes
 		fail();
+		wallSeconds += tickSeconds;
+		maxTickSeconds = max(maxTickSeconds, tickSeconds);
+	}
+
+	// Report convergence and message counts for this gossip configuration
+	if ( !allNodesJoined ) {
+		timeWhenAllNodesHaveJoined = -1;
+	}
+	cout << "Full membership at time " << timeWhenAllNodesHaveJoined << ", messages sent " << en->getTotalSent() << ", received " << en->getTotalRecv()
+		 << ", dropped on full buffer " << en->getOverflowDrops() << ", dropped oversize " << en->getOversizeDrops() << endl;
+	if ( en->getSyscalls() > 0 ) {
+		cout << "System calls " << en->getSyscalls() << ", " << (double)en->getSyscalls() / par->TOTAL_RUNNING_TIME << " per time unit" << endl;
+	}
+	log->LOG(&mp1[0]->getMemberNode()->addr, "#STATSLOG# full membership at time %d, fanout %d, gossip interval %d, sent %ld, recv %ld, overflow %ld, oversize %ld",
+			timeWhenAllNodesHaveJoined, par->GOSSIP_FANOUT, par->GOSSIP_INTERVAL, en->getTotalSent(), en->getTotalRecv(), en->getOverflowDrops(), en->getOversizeDrops());
+	if ( par->BENCH_REPORT ) {
+		writeBenchReport(wallSeconds, maxTickSeconds, timeWhenAllNodesHaveJoined);
 	}
 
 	// Clean up
@@ -113,54 +172,298 @@ int Application::run()
 	return SUCCESS;
 }
 
+/**
+ * FUNCTION NAME: runWorkers
+ *
+ * DESCRIPTION: Fork the worker processes of the shared-memory transport and
+ * 				run the time loop in each of them, stepping only the nodes the
+ * 				worker owns. The parent waits, merges the workers' logs into
+ * 				its own and reports each worker's resource usage.
+ *
+ * RETURNS:
+ * time at which every live node had full membership, -1 if never
+ */
+int Application::runWorkers(ShmNet *shm, double *wallSeconds, double *maxTickSeconds) {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	// nothing buffered may be inherited, or it would be written twice
+	log->flush();
+	cout.flush();
+	fflush(stdout);
+
+	int w = shm->spawn();
+	if ( w >= 0 ) {
+		worker = w;
+		processes = shm->getWorkers();
+		log->startWorker(w);
+		for( par->globaltime = 0; par->globaltime < par->TOTAL_RUNNING_TIME; ++par->globaltime ) {
+			chrono::steady_clock::time_point tickStart = chrono::steady_clock::now();
+			mp1Run();
+			shm->noteTick(chrono::duration<double>(chrono::steady_clock::now() - tickStart).count(), allNodesHaveFullMembership());
+			fail();
+		}
+		for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+			if ( owns(i) ) {
+				mp1[i]->finishUpThisNode();
+			}
+		}
+		log->finishWorker();
+		cout.flush();
+		shm->finishWorker(SUCCESS);
+	}
+
+	if ( !shm->waitWorkers() ) {
+		cout << "A worker process failed" << endl;
+	}
+	*wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	*maxTickSeconds = shm->getMaxTick();
+	par->globaltime = par->TOTAL_RUNNING_TIME;
+	log->mergeWorkers(shm->getWorkers());
+	for ( int i = 0; i < shm->getWorkers(); i++ ) {
+		shm_worker *stats = shm->getWorkerStats(i);
+		cout << "Worker " << i << ": " << stats->nodes << " nodes, peak RSS " << stats->peakRssKb << " KB, CPU " << stats->cpuSeconds << " s" << endl;
+	}
+	return shm->firstFullTime();
+}
+
+/**
+ * FUNCTION NAME: runEvents
+ *
+ * DESCRIPTION: Discrete-event engine. Instead of stepping every node every time
+ * 				unit, the time jumps to the next event: a node starting, a message
+ * 				delivery (as timed by the LinkModel), a timer the node
+ * 				reported through MP1Node::nextWakeup, or a fail() control time.
+ * 				Node 0 is also stepped every TIME_LOG_INTERVAL to log the time.
+ * 				Only the nodes with an event are stepped, in the order of the
+ * 				tick loop, so with LATENCY 1 the run matches a tick loop run
+ * 				with the same SEED. par->globaltime holds the current event time.
+ * 				Node i has EmulNet id i + 1.
+ *
+ * RETURNS:
+ * time at which every live node had full membership, -1 if never
+ */
+int Application::runEvents(EmulNet *emul, double *wallSeconds, double *maxTickSeconds) {
+	EventQueue queue(par->EN_GPSZ);
+	vector<int> due;
+	int fullTime = -1;
+	long steps = 0, nodeSteps = 0;
+
+	emul->ENsetDeliveryListener([&queue](int id, long time) { queue.wake(id - 1, time); });
+	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+		queue.wake(i, (int)(par->STEP_RATE*i));
+	}
+	queue.control(DROP_START_TIME);
+	queue.control(FAIL_TIME);
+	queue.control(DROP_END_TIME);
+	for ( long t = TIME_LOG_INTERVAL; t < par->TOTAL_RUNNING_TIME; t += TIME_LOG_INTERVAL ) {
+		queue.control(t);
+	}
+
+	while ( !queue.empty() && queue.nextTime() < par->TOTAL_RUNNING_TIME ) {
+		chrono::steady_clock::time_point stepStart = chrono::steady_clock::now();
+		par->globaltime = queue.nextTime();
+		bool control = queue.popDue(par->globaltime, due);
+		emul->ENdeliverDue(par->globaltime);
+		if ( par->globaltime % TIME_LOG_INTERVAL == 0 && find(due.begin(), due.end(), 0) == due.end() ) {
+			due.push_back(0);
+		}
+
+		sort(due.begin(), due.end(), greater<int>());
+		for ( int i : due ) {
+			recvStep(i);
+			loopStep(i);
+			reportStart(i);
+			long next = mp1[i]->nextWakeup();
+			if ( par->getcurrtime() < (int)(par->STEP_RATE*i) ) {
+				next = (int)(par->STEP_RATE*i);
+			}
+			if ( next >= 0 ) {
+				queue.wake(i, next);
+			}
+		}
+		double stepSeconds = chrono::duration<double>(chrono::steady_clock::now() - stepStart).count();
+
+		if ( fullTime < 0 && allNodesHaveFullMembership() ) {
+			fullTime = par->getcurrtime();
+		}
+		if ( control ) {
+			fail();
+		}
+		*wallSeconds += stepSeconds;
+		*maxTickSeconds = max(*maxTickSeconds, stepSeconds);
+		steps++;
+		nodeSteps += due.size();
+	}
+
+	emul->ENsetDeliveryListener(nullptr);
+	par->globaltime = par->TOTAL_RUNNING_TIME;
+	cout << "Event engine: " << steps << " of " << par->TOTAL_RUNNING_TIME << " time units had events, " << nodeSteps << " node steps, mean delivery delay " << emul->getMeanDelay() << endl;
+	return fullTime;
+}
+
+/**
+ * FUNCTION NAME: owns
+ *
+ * DESCRIPTION: Return true if this process steps the ith node
+ */
+bool Application::owns(int i) {
+	return processes == 1 || i % processes == worker;
+}
+
 /**
  * FUNCTION NAME: mp1Run
  *
- * DESCRIPTION:	This function performs all the membership protocol functionalities
+ * DESCRIPTION:	This function performs all the membership protocol functionalities.
+ * 				With THREADS > 1 both passes run on the thread pool. If DETERMINISTIC,
+ * 				sends and log lines are staged per node and flushed in the order of
+ * 				the serial pass, so the run is identical to a serial one with the
+ * 				same SEED; otherwise they go straight to the inboxes and the log.
  */
 void Application::mp1Run() {
 	int i;
 
-	// For all the nodes in the system
-	for( i = 0; i <= par->EN_GPSZ-1; i++) {
-
-		/*
-		 * Receive messages from the network and queue them in the membership protocol queue
-		 */
-		if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
-			// Receive messages from the network and queue them
-			mp1[i]->recvLoop();
+	if ( workers == NULL ) {
+		// For all the nodes in the system
+		for( i = 0; i <= par->EN_GPSZ-1; i++) {
+			recvStep(i);
 		}
+		en->ENsync();
 
+		// For all the nodes in the system
+		for( i = par->EN_GPSZ - 1; i >= 0; i-- ) {
+			loopStep(i);
+			reportStart(i);
+		}
+		en->ENsync();
+		return;
 	}
 
-	// For all the nodes in the system
+	bool stage = par->DETERMINISTIC;
+	en->ENsetStaging(stage);
+	log->setStaging(stage);
+	workers->parallelFor(0, par->EN_GPSZ, [this](int i) { recvStep(i); });
+	workers->parallelFor(0, par->EN_GPSZ, [this](int i) { loopStep(i); });
+	en->ENsetStaging(false);
+	log->setStaging(false);
+
 	for( i = par->EN_GPSZ - 1; i >= 0; i-- ) {
+		reportStart(i);
+		if ( stage ) {
+			log->flushStaged(&mp1[i]->getMemberNode()->addr);
+			en->ENflushStaged(&mp1[i]->getMemberNode()->addr);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: recvStep
+ *
+ * DESCRIPTION: Receive pass of the ith node
+ */
+void Application::recvStep(int i) {
+	if ( !owns(i) ) {
+		return;
+	}
+	/*
+	 * Receive messages from the network and queue them in the membership protocol queue
+	 */
+	if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
+		// Receive messages from the network and queue them
+		mp1[i]->recvLoop();
+	}
+}
 
-		/*
-		 * Introduce nodes into the distributed system
-		 */
-		if( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
-			// introduce the ith node into the system at time STEPRATE*i
-			mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
-			cout<<i<<"-th introduced node is assigned with the address: "<<mp1[i]->getMemberNode()->addr.getAddress() << endl;
-			nodeCount += i;
+/**
+ * FUNCTION NAME: loopStep
+ *
+ * DESCRIPTION: Start the ith node when its time comes, or let it handle its
+ * 				messages and send heartbeats. Touches only the ith node's state.
+ */
+void Application::loopStep(int i) {
+	if ( !owns(i) ) {
+		return;
+	}
+	/*
+	 * Introduce nodes into the distributed system
+	 */
+	if( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
+		// introduce the ith node into the system at time STEPRATE*i
+		mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
+	}
+
+	/*
+	 * Handle all the messages in your queue and send heartbeats
+	 */
+	else if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
+		// handle messages and send heartbeats
+		mp1[i]->nodeLoop();
+		#ifdef DEBUGLOG
+		if( (i == 0) && (par->globaltime % TIME_LOG_INTERVAL == 0) ) {
+			log->LOG(&mp1[i]->getMemberNode()->addr, "@@time=%d", par->getcurrtime());
 		}
+		#endif
+	}
+}
 
-		/*
-		 * Handle all the messages in your queue and send heartbeats
-		 */
-		else if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
-			// handle messages and send heartbeats
-			mp1[i]->nodeLoop();
-			#ifdef DEBUGLOG
-			if( (i == 0) && (par->globaltime % 500 == 0) ) {
-				log->LOG(&mp1[i]->getMemberNode()->addr, "@@time=%d", par->getcurrtime());
-			}
-			#endif
+/**
+ * FUNCTION NAME: reportStart
+ *
+ * DESCRIPTION: Announce the ith node if it was introduced in this tick
+ */
+void Application::reportStart(int i) {
+	if ( !owns(i) ) {
+		return;
+	}
+	if( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
+		cout<<i<<"-th introduced node is assigned with the address: "<<mp1[i]->getMemberNode()->addr.getAddress() << endl;
+		nodeCount += i;
+	}
+}
+
+/**
+ * FUNCTION NAME: allNodesHaveFullMembership
+ *
+ * DESCRIPTION: Return true if every live node this process steps knows every other node
+ */
+bool Application::allNodesHaveFullMembership() {
+	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+		if ( !owns(i) ) {
+			continue;
+		}
+		if ( mp1[i]->getMemberNode()->bFailed || !mp1[i]->hasFullMembership() ) {
+			return false;
 		}
+	}
+	return true;
+}
 
+/**
+ * FUNCTION NAME: writeBenchReport
+ *
+ * DESCRIPTION: Append one line of JSON describing this run to BENCH_FILE:
+ * 				the configuration, wall-clock per tick, peak RSS, traffic per
+ * 				tick and the time at which every node had full membership
+ */
+void Application::writeBenchReport(double wallSeconds, double maxTickSeconds, int fullMembershipTime) {
+	struct rusage usage;
+	int ticks = par->TOTAL_RUNNING_TIME;
+	FILE *fp = fopen(BENCH_FILE, "a");
+	if ( fp == NULL ) {
+		cout << "Could not open " << BENCH_FILE << endl;
+		return;
 	}
+	getrusage(RUSAGE_SELF, &usage);
+	long peakRss = usage.ru_maxrss;
+	// worker processes of the shared-memory transport count too
+	getrusage(RUSAGE_CHILDREN, &usage);
+	peakRss = max(peakRss, usage.ru_maxrss);
+	fprintf(fp, "{\"nodes\": %d, \"transport\": %d, \"sim_engine\": %d, \"threads\": %d, \"single_failure\": %d, \"drop_msg\": %d, \"drop_prob\": %g, \"fanout\": %d, \"gossip_interval\": %d, \"delta_gossip\": %d, \"step_rate\": %g, "
+			"\"ticks\": %d, \"wall_s\": %.3f, \"ms_per_tick\": %.4f, \"max_tick_ms\": %.4f, \"ticks_per_s\": %.1f, \"peak_rss_kb\": %ld, "
+			"\"msgs_per_tick\": %.1f, \"bytes_per_tick\": %.1f, \"syscalls_per_tick\": %.1f, \"full_membership_time\": %d}\n",
+			par->EN_GPSZ, par->TRANSPORT, par->SIM_ENGINE, par->THREADS, par->SINGLE_FAILURE, par->DROP_MSG, par->MSG_DROP_PROB, par->GOSSIP_FANOUT, par->GOSSIP_INTERVAL, par->DELTA_GOSSIP, par->STEP_RATE,
+			ticks, wallSeconds, 1000 * wallSeconds / ticks, 1000 * maxTickSeconds, ticks / wallSeconds, peakRss,
+			(double)en->getTotalSent() / ticks, (double)en->getTotalBytes() / ticks, (double)en->getSyscalls() / ticks, fullMembershipTime);
+	fclose(fp);
 }
 
 /**
@@ -174,28 +477,33 @@ void Application::fail() {
 	int i, removed;
 
 	// fail half the members at time t=400
-	if( par->DROP_MSG && par->getcurrtime() == 50 ) {
+	if( par->DROP_MSG && par->getcurrtime() == DROP_START_TIME ) {
 		par->dropmsg = 1;
 	}
 
-	if( par->SINGLE_FAILURE && par->getcurrtime() == 100 ) {
+	if( par->SINGLE_FAILURE && par->getcurrtime() == FAIL_TIME ) {
 		removed = (rand() % par->EN_GPSZ);
 		#ifdef DEBUGLOG
-		log->LOG(&mp1[removed]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
+		// every worker process marks the node, only its owner logs it
+		if ( owns(removed) ) {
+			log->LOG(&mp1[removed]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
+		}
 		#endif
 		mp1[removed]->getMemberNode()->bFailed = true;
 	}
-	else if( par->getcurrtime() == 100 ) {
+	else if( par->getcurrtime() == FAIL_TIME ) {
 		removed = rand() % par->EN_GPSZ/2;
 		for ( i = removed; i < removed + par->EN_GPSZ/2; i++ ) {
 			#ifdef DEBUGLOG
-			log->LOG(&mp1[i]->getMemberNode()->addr, "Node failed at time = %d", par->getcurrtime());
+			if ( owns(i) ) {
+				log->LOG(&mp1[i]->getMemberNode()->addr, "Node failed at time = %d", par->getcurrtime());
+			}
 			#endif
 			mp1[i]->getMemberNode()->bFailed = true;
 		}
 	}
 
-	if( par->DROP_MSG && par->getcurrtime() == 300) {
+	if( par->DROP_MSG && par->getcurrtime() == DROP_END_TIME) {
 		par->dropmsg=0;
 	}
 
@@ -208,10 +516,7 @@ void Application::fail() {
  */
 Address Application::getjoinaddr(void){
 	//trace.funcEntry("Application::getjoinaddr");
-    Address joinaddr;
-    joinaddr.init();
-    *(int *)(&(joinaddr.addr))=1;
-    *(short *)(&(joinaddr.addr[4]))=0;
+    Address joinaddr(1, 0);
     //trace.funcExit("Application::getjoinaddr", SUCCESS);
     return joinaddr;
 }
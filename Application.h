@@ -12,8 +12,12 @@
 #include "Log.h"
 #include "Params.h"
 #include "Member.h"
+#include "Transport.h"
+#include "ShmNet.h"
 #include "EmulNet.h"
+#include "EventQueue.h"
 #include "Queue.h"
+#include "ThreadPool.h"
 
 /**
  * global variables
@@ -24,7 +28,14 @@ int nodeCount = 0;
  * Macros
  */
 #define ARGS_COUNT 2
-#define TOTAL_RUNNING_TIME 700
+// file the scale benchmark results are appended to, one JSON object per line
+#define BENCH_FILE "bench.jsonl"
+// times at which fail() turns message drops on, fails nodes and turns drops off
+#define DROP_START_TIME 50
+#define FAIL_TIME 100
+#define DROP_END_TIME 300
+// node 0 logs the time every TIME_LOG_INTERVAL time units
+#define TIME_LOG_INTERVAL 500
 
 /**
  * CLASS NAME: Application
@@ -36,10 +47,22 @@ private:
 	// Address for introduction to the group
 	// Coordinator Node
 	char JOINADDR[30];
-	EmulNet *en;
+	Transport *en;
     Log *log;
 	MP1Node **mp1;
 	Params *par;
+	// steps the nodes when THREADS > 1, NULL otherwise
+	ThreadPool *workers;
+	// with the shared-memory transport, the node stepping worker process this
+	// is and how many there are; a single process owns every node
+	int worker;
+	int processes;
+	bool owns(int i);
+	int runWorkers(ShmNet *shm, double *wallSeconds, double *maxTickSeconds);
+	int runEvents(EmulNet *emul, double *wallSeconds, double *maxTickSeconds);
+	void recvStep(int i);
+	void loopStep(int i);
+	void reportStart(int i);
 public:
 	Application(char *);
 	virtual ~Application();
@@ -47,6 +70,8 @@ public:
 	int run();
 	void mp1Run();
 	void fail();
+	bool allNodesHaveFullMembership();
+	void writeBenchReport(double wallSeconds, double maxTickSeconds, int fullMembershipTime);
 };
 
 #endif /* _APPLICATION_H__ */
@@ -0,0 +1,301 @@
+/**********************************
+ * FILE NAME: Bench.cpp
+ *
+ * DESCRIPTION: Microbenchmarks for the EmulNet and MP1Node hot paths.
+ * 				Built by "make bench". Prints a JSON array with one object per
+ * 				benchmark and size, giving ns/op and heap allocations/op.
+ **********************************/
+
+#include "stdincludes.h"
+#include "Params.h"
+#include "Member.h"
+#include "EmulNet.h"
+#include "Log.h"
+#include "Queue.h"
+#include "MP1Node.h"
+
+/*
+ * Macros
+ */
+// time spent in each benchmark, in nanoseconds
+#define BENCH_MIN_NS 200000000L
+// operations per batch for the cheap benchmarks
+#define BENCH_BATCH 4096
+// payload of the EmulNet benchmarks
+#define BENCH_PAYLOAD 64
+
+/*
+ * Every malloc in the process, including those behind operator new,
+ * goes through this counter.
+ */
+static atomic<long> allocCount(0);
+
+extern "C" void *__libc_malloc(size_t size);
+
+extern "C" void *malloc(size_t size) throw() {
+	allocCount.fetch_add(1, memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+static bool firstResult = true;
+
+/**
+ * FUNCTION NAME: nowNs
+ *
+ * DESCRIPTION: Monotonic clock in nanoseconds
+ */
+static long nowNs() {
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * FUNCTION NAME: runBench
+ *
+ * DESCRIPTION: Alternate prepare() (untimed) and op() (timed) until BENCH_MIN_NS
+ * 				have been spent in op, then print the result. op returns the number
+ * 				of operations it performed.
+ */
+template <typename Prepare, typename Op>
+static void runBench(const char *name, int groupSize, int listSize, Prepare prepare, Op op) {
+	long ops = 0, ns = 0, allocs = 0;
+	while ( ns < BENCH_MIN_NS ) {
+		prepare();
+		long a0 = allocCount.load();
+		long t0 = nowNs();
+		ops += op();
+		ns += nowNs() - t0;
+		allocs += allocCount.load() - a0;
+	}
+	printf("%s\n  {\"name\": \"%s\", \"group_size\": %d, \"list_size\": %d, \"ops\": %ld, \"ns_per_op\": %.2f, \"allocs_per_op\": %.4f}",
+			firstResult ? "" : ",", name, groupSize, listSize, ops, (double)ns / ops, (double)allocs / ops);
+	firstResult = false;
+	fflush(stdout);
+}
+
+/**
+ * CLASS NAME: BenchWorld
+ *
+ * DESCRIPTION: An EmulNet holding groupSize nodes and a single MP1Node (id 1)
+ * 				whose membership list holds ids 2 .. listSize + 1
+ */
+class BenchWorld {
+public:
+	Params par;
+	EmulNet *en;
+	Log *log;
+	vector<Address> addrs;
+	Member *member;
+	MP1Node *node;
+	queue<q_elt> inbox;
+	BenchWorld(int groupSize, int listSize, int maxMsgSize);
+	virtual ~BenchWorld();
+	void refresh();
+	void drain();
+};
+
+/**
+ * Constructor
+ */
+BenchWorld::BenchWorld(int groupSize, int listSize, int maxMsgSize) {
+	par.setdefaults();
+	par.MAX_NNB = groupSize;
+	par.EN_GPSZ = groupSize;
+	par.MAX_MSG_SIZE = maxMsgSize;
+	par.globaltime = 1;
+	en = new EmulNet(&par);
+	log = new Log(&par);
+	// addrs[i] is node id i; id 0 is unused
+	addrs.resize(groupSize + 1);
+	for ( int i = 1; i <= groupSize; i++ ) {
+		en->ENinit(&addrs[i], par.PORTNUM);
+	}
+	member = new Member;
+	node = new MP1Node(member, &par, en, log, &addrs[1]);
+	node->initThisNode(&addrs[1]);
+	member->inGroup = true;
+	for ( int id = 2; id <= listSize + 1; id++ ) {
+		MemberListEntry e(id, 0, 1, par.globaltime);
+		node->armTimer(member->memberList.insert(e));
+	}
+}
+
+/**
+ * Destructor
+ */
+BenchWorld::~BenchWorld() {
+	drain();
+	delete node;
+	delete member;
+	delete log;
+	delete en;
+}
+
+/**
+ * FUNCTION NAME: refresh
+ *
+ * DESCRIPTION: Mark every member as just heard from, so nodeLoopOps removes nobody
+ */
+void BenchWorld::refresh() {
+	for ( int i = 0; i < member->memberList.size(); i++ ) {
+		member->memberList[i].settimestamp(par.globaltime);
+		node->armTimer(&member->memberList[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: drain
+ *
+ * DESCRIPTION: Receive and release every message in flight
+ */
+void BenchWorld::drain() {
+	for ( int i = 1; i < (int)addrs.size(); i++ ) {
+		en->ENrecv(&addrs[i], MP1Node::enqueueWrapper, NULL, 1, &inbox);
+	}
+	while ( !inbox.empty() ) {
+		en->ENrelease((char *)inbox.front().elt);
+		inbox.pop();
+	}
+}
+
+/**
+ * FUNCTION NAME: benchENsend
+ *
+ * DESCRIPTION: Cost of one ENsend between random members of the group
+ */
+static void benchENsend(int groupSize) {
+	BenchWorld w(groupSize, 0, 4000);
+	char payload[BENCH_PAYLOAD] = {0};
+	minstd_rand rng(1);
+	runBench("ENsend", groupSize, 0, [&]() { w.drain(); }, [&]() {
+		for ( int i = 0; i < BENCH_BATCH; i++ ) {
+			w.en->ENsend(&w.addrs[1 + rng() % groupSize], &w.addrs[1 + rng() % groupSize], payload, BENCH_PAYLOAD);
+		}
+		return (long)BENCH_BATCH;
+	});
+}
+
+/**
+ * FUNCTION NAME: benchENrecv
+ *
+ * DESCRIPTION: Cost per message of ENrecv over every node, with BENCH_BATCH
+ * 				messages spread over the group
+ */
+static void benchENrecv(int groupSize) {
+	BenchWorld w(groupSize, 0, 4000);
+	char payload[BENCH_PAYLOAD] = {0};
+	minstd_rand rng(1);
+	runBench("ENrecv", groupSize, 0, [&]() {
+		while ( !w.inbox.empty() ) {
+			w.en->ENrelease((char *)w.inbox.front().elt);
+			w.inbox.pop();
+		}
+		for ( int i = 0; i < BENCH_BATCH; i++ ) {
+			w.en->ENsend(&w.addrs[1 + rng() % groupSize], &w.addrs[1 + rng() % groupSize], payload, BENCH_PAYLOAD);
+		}
+	}, [&]() {
+		for ( int i = 1; i <= groupSize; i++ ) {
+			w.en->ENrecv(&w.addrs[i], MP1Node::enqueueWrapper, NULL, 1, &w.inbox);
+		}
+		return (long)w.inbox.size();
+	});
+}
+
+/**
+ * FUNCTION NAME: benchEnqueue
+ *
+ * DESCRIPTION: Cost of one Queue::enqueue
+ */
+static void benchEnqueue() {
+	queue<q_elt> q;
+	char payload[BENCH_PAYLOAD];
+	runBench("Queue::enqueue", 0, 0, [&]() { queue<q_elt> empty; swap(q, empty); }, [&]() {
+		for ( int i = 0; i < BENCH_BATCH; i++ ) {
+			Queue::enqueue(&q, payload, BENCH_PAYLOAD);
+		}
+		return (long)BENCH_BATCH;
+	});
+}
+
+/**
+ * FUNCTION NAME: benchGetMemberIfPresent
+ *
+ * DESCRIPTION: Cost of one lookup of a present member in a list of listSize
+ */
+static void benchGetMemberIfPresent(int listSize) {
+	BenchWorld w(listSize + 1, listSize, 4000);
+	vector<int> ids(BENCH_BATCH);
+	minstd_rand rng(1);
+	for ( int &id : ids ) {
+		id = 2 + rng() % listSize;
+	}
+	long found = 0;
+	runBench("getMemberIfPresent", listSize + 1, listSize, [&]() {}, [&]() {
+		for ( int id : ids ) {
+			found += (w.node->getMemberIfPresent(id, 0) != nullptr);
+		}
+		return (long)BENCH_BATCH;
+	});
+	assert(found > 0);
+}
+
+/**
+ * FUNCTION NAME: benchHandlePing
+ *
+ * DESCRIPTION: Cost of merging one PING that carries the whole membership list
+ */
+static void benchHandlePing(int listSize) {
+	int size = MessageWriter::encodedSize(listSize);
+	BenchWorld w(listSize + 1, listSize, size + sizeof(en_msg) + 1);
+	vector<char> msg(size);
+	MessageWriter writer(&msg[0], size, PING, &w.addrs[2], 1, 0);
+	for ( int i = 0; i < w.member->memberList.size(); i++ ) {
+		writer.append(&w.member->memberList[i]);
+	}
+	MessageView view(&msg[0], writer.getSize());
+	int calls = max(1, BENCH_BATCH / listSize);
+	runBench("handlePing", listSize + 1, listSize, [&]() {}, [&]() {
+		for ( int i = 0; i < calls; i++ ) {
+			w.node->handlePing(&view);
+		}
+		return (long)calls;
+	});
+}
+
+/**
+ * FUNCTION NAME: benchNodeLoopOps
+ *
+ * DESCRIPTION: Cost of one gossip round of a node that knows the whole group
+ */
+static void benchNodeLoopOps(int groupSize) {
+	BenchWorld w(groupSize, groupSize - 1, 4000);
+	runBench("nodeLoopOps", groupSize, groupSize - 1, [&]() {
+		w.drain();
+		w.par.globaltime++;
+		w.refresh();
+	}, [&]() {
+		w.node->nodeLoopOps();
+		return 1L;
+	});
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Run every benchmark for group and list sizes 10 to 10k
+ **********************************/
+int main(int argc, char *argv[]) {
+	int sizes[] = {10, 100, 1000, 10000};
+
+	printf("[");
+	benchEnqueue();
+	for ( int n : sizes ) {
+		benchENsend(n);
+		benchENrecv(n);
+		benchGetMemberIfPresent(n);
+		benchHandlePing(n);
+		benchNodeLoopOps(n);
+	}
+	printf("\n]\n");
+
+	return SUCCESS;
+}
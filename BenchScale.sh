@@ -0,0 +1,63 @@
+#**********************
+#*
+#* Progam Name: MP1. Membership Protocol.
+#*
+#* Current file: BenchScale.sh
+#* About this file: Scale benchmark driver.
+#* 	Runs the simulator on generated configurations for N = 10, 100, 300 and
+#* 	1000 nodes, with and without message drop, and collects one JSON line
+#* 	per run in bench.jsonl. Pass node counts as arguments to run others,
+#* 	and set THREADS in the environment to step the nodes in parallel.
+#* 	Exits non-zero if any run never reached full membership, as its
+#* 	numbers then describe a group that did not converge.
+#* 
+#***********************
+#!/bin/bash
+
+SIZES=${@:-"10 100 300 1000"}
+THREADS=${THREADS:-1}
+CONFDIR=bench-confs
+
+make > /dev/null || { echo 'ERROR ... build failed'; exit 1; }
+rm -rf $CONFDIR bench.jsonl
+mkdir $CONFDIR
+
+for n in $SIZES
+do
+	for drop in 0 1
+	do
+		conf=$CONFDIR/n$n-drop$drop.conf
+		echo "MAX_NNB: $n" > $conf
+		echo "SINGLE_FAILURE: 1" >> $conf
+		echo "DROP_MSG: $drop" >> $conf
+		echo "MSG_DROP_PROB: 0.1" >> $conf
+		echo "BENCH_REPORT: 1" >> $conf
+		echo "THREADS: $THREADS" >> $conf
+		# Past 100 nodes, gossip to a few random members instead of everyone,
+		# start all nodes within the first 50 ticks so the group can converge
+		# before the failure at time 100, and keep dbg.log small. At 300 nodes
+		# the list no longer fits in one PING, so each PING carries part of it.
+		if [ $n -gt 100 ]; then
+			echo "GOSSIP_FANOUT: 3" >> $conf
+			echo "STEP_RATE: $(awk "BEGIN { print 50 / $n }")" >> $conf
+			echo "QUIET_LOG: 1" >> $conf
+		fi
+		# From 1000 nodes, a heartbeat carried by one PING in several spreads
+		# slower than TFAIL rounds, so PINGs are sized for the whole list
+		if [ $n -ge 1000 ]; then
+			echo "MAX_MSG_SIZE: $((20 * n + 100))" >> $conf
+		fi
+		echo "Running $conf"
+		./Application $conf > /dev/null
+		if tail -n 1 bench.jsonl | grep -q '"full_membership_time": -1'; then
+			failed="$failed $conf"
+		fi
+	done
+done
+
+rm -rf $CONFDIR
+cat bench.jsonl
+if [ -n "$failed" ]; then
+	echo "ERROR ... no full membership in:$failed"
+	exit 1
+fi
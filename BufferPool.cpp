@@ -0,0 +1,83 @@
+/**********************************
+ * FILE NAME: BufferPool.cpp
+ *
+ * DESCRIPTION: Definition of BufferPool class
+ **********************************/
+
+#include "BufferPool.h"
+
+/**
+ * Destructor
+ */
+BufferPool::~BufferPool() {
+	for ( char *slab : slabs ) {
+		free(slab);
+	}
+}
+
+/**
+ * FUNCTION NAME: sizeClass
+ *
+ * DESCRIPTION: Smallest class whose blocks hold size bytes plus the block header,
+ * 				or -1 if none does
+ */
+int BufferPool::sizeClass(int size) {
+	int cls = 0;
+	while ( cls < POOL_NUM_CLASSES && (1 << (POOL_MIN_SHIFT + cls)) < size + POOL_HDR_SIZE ) {
+		cls++;
+	}
+	return cls < POOL_NUM_CLASSES ? cls : -1;
+}
+
+/**
+ * FUNCTION NAME: refill
+ *
+ * DESCRIPTION: Carve a new slab into blocks of class cls
+ */
+void BufferPool::refill(int cls) {
+	int blockSize = 1 << (POOL_MIN_SHIFT + cls);
+	char *slab = (char *) malloc(POOL_SLAB_SIZE);
+	slabs.push_back(slab);
+	for ( int off = POOL_SLAB_SIZE - blockSize; off >= 0; off -= blockSize ) {
+		*(int *)(slab + off) = cls;
+		freeList[cls].push_back(slab + off);
+	}
+}
+
+/**
+ * FUNCTION NAME: alloc
+ *
+ * DESCRIPTION: Return a buffer of at least size bytes
+ */
+void *BufferPool::alloc(int size) {
+	char *block;
+	int cls = sizeClass(size);
+	if ( cls < 0 ) {
+		block = (char *) malloc(size + POOL_HDR_SIZE);
+		*(int *)block = -1;
+	}
+	else {
+		if ( freeList[cls].empty() ) {
+			refill(cls);
+		}
+		block = (char *) freeList[cls].back();
+		freeList[cls].pop_back();
+	}
+	return block + POOL_HDR_SIZE;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Give back a buffer obtained from alloc
+ */
+void BufferPool::release(void *buf) {
+	char *block = (char *)buf - POOL_HDR_SIZE;
+	int cls = *(int *)block;
+	if ( cls < 0 ) {
+		free(block);
+	}
+	else {
+		freeList[cls].push_back(block);
+	}
+}
@@ -0,0 +1,48 @@
+/**********************************
+ * FILE NAME: BufferPool.h
+ *
+ * DESCRIPTION: Slab allocator for message buffers
+ **********************************/
+
+#ifndef _BUFFERPOOL_H_
+#define _BUFFERPOOL_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// smallest block is 1 << POOL_MIN_SHIFT bytes
+#define POOL_MIN_SHIFT 6
+// number of power-of-two size classes, up to 1 << (POOL_MIN_SHIFT + POOL_NUM_CLASSES - 1)
+#define POOL_NUM_CLASSES 8
+// bytes carved into blocks at a time
+#define POOL_SLAB_SIZE (64 * 1024)
+// room kept in front of every block to remember its size class
+#define POOL_HDR_SIZE 16
+
+/**
+ * CLASS NAME: BufferPool
+ *
+ * DESCRIPTION: Hands out buffers from power-of-two size classes carved out of
+ * 				large slabs. Released buffers go on a per-class free list and are
+ * 				reused, so steady-state traffic does not touch malloc. Requests
+ * 				larger than the biggest class fall back to malloc. Slabs are
+ * 				returned to the system only when the pool is destroyed.
+ */
+class BufferPool {
+private:
+	vector<void *> freeList[POOL_NUM_CLASSES];
+	vector<char *> slabs;
+	BufferPool(const BufferPool &anotherPool);
+	BufferPool& operator =(const BufferPool &anotherPool);
+	static int sizeClass(int size);
+	void refill(int cls);
+public:
+	BufferPool() {}
+	virtual ~BufferPool();
+	void *alloc(int size);
+	void release(void *buf);
+};
+
+#endif /* _BUFFERPOOL_H_ */
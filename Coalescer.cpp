@@ -0,0 +1,120 @@
+/**********************************
+ * FILE NAME: Coalescer.cpp
+ *
+ * DESCRIPTION: Definition of Coalescer class
+ **********************************/
+
+#include "Coalescer.h"
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Queue a message for to, sending the destination's frame first
+ * 				if the message would not fit in it
+ */
+void Coalescer::add(Transport *net, Address *from, Address *to, char *data, int size) {
+	int idx;
+	unordered_map<long, int>::iterator it = frameOf.find(to->getKey());
+	if ( it == frameOf.end() ) {
+		if ( used == (int)frames.size() ) {
+			frames.push_back(coalesce_frame());
+		}
+		idx = used++;
+		frameOf[to->getKey()] = idx;
+		frames[idx].to = *to;
+		frames[idx].count = 0;
+	}
+	else {
+		idx = it->second;
+	}
+	coalesce_frame &frame = frames[idx];
+	if ( frame.count > 0 && (int)frame.buf.size() + BATCH_LEN_SIZE + size > net->ENmaxPayload() ) {
+		send(net, from, frame);
+	}
+	if ( frame.count == 0 ) {
+		frame.buf.assign(BATCH_HDR_SIZE, 0);
+		frame.buf[0] = BATCH;
+	}
+	frame.buf.insert(frame.buf.end(), (char *)&size, (char *)&size + BATCH_LEN_SIZE);
+	frame.buf.insert(frame.buf.end(), data, data + size);
+	frame.count++;
+}
+
+/**
+ * FUNCTION NAME: has
+ *
+ * DESCRIPTION: Whether messages for to are waiting
+ */
+bool Coalescer::has(Address *to) {
+	if ( used == 0 ) {
+		return false;
+	}
+	unordered_map<long, int>::iterator it = frameOf.find(to->getKey());
+	return it != frameOf.end() && frames[it->second].count > 0;
+}
+
+/**
+ * FUNCTION NAME: flush
+ *
+ * DESCRIPTION: Send every waiting frame and start the next step empty
+ */
+void Coalescer::flush(Transport *net, Address *from) {
+	for ( int i = 0; i < used; i++ ) {
+		if ( frames[i].count > 0 ) {
+			send(net, from, frames[i]);
+		}
+	}
+	used = 0;
+	frameOf.clear();
+}
+
+/**
+ * FUNCTION NAME: send
+ *
+ * DESCRIPTION: Send one frame, unwrapped if it holds a single message, and empty it
+ */
+void Coalescer::send(Transport *net, Address *from, coalesce_frame &frame) {
+	if ( frame.count == 1 ) {
+		int offset = BATCH_HDR_SIZE + BATCH_LEN_SIZE;
+		net->ENsend(from, &frame.to, &frame.buf[offset], (int)frame.buf.size() - offset);
+	}
+	else {
+		unsigned short count = (unsigned short)frame.count;
+		memcpy(&frame.buf[1], &count, sizeof(count));
+		net->ENsend(from, &frame.to, &frame.buf[0], (int)frame.buf.size());
+	}
+	frame.count = 0;
+}
+
+/**
+ * FUNCTION NAME: unpack
+ *
+ * DESCRIPTION: List the messages framed in a received BATCH as (start, size)
+ * 				pairs pointing into data
+ *
+ * RETURNS:
+ * false if data is not a well-formed BATCH
+ */
+bool Coalescer::unpack(char *data, int size, vector< pair<char *, int> > &out) {
+	unsigned short count;
+	out.clear();
+	if ( size < BATCH_HDR_SIZE || data[0] != BATCH ) {
+		return false;
+	}
+	memcpy(&count, data + 1, sizeof(count));
+	int offset = BATCH_HDR_SIZE;
+	for ( int i = 0; i < count; i++ ) {
+		int len;
+		if ( size - offset < BATCH_LEN_SIZE ) {
+			return false;
+		}
+		memcpy(&len, data + offset, BATCH_LEN_SIZE);
+		offset += BATCH_LEN_SIZE;
+		if ( len < 0 || len > size - offset ) {
+			return false;
+		}
+		out.push_back(make_pair(data + offset, len));
+		offset += len;
+	}
+	return true;
+}
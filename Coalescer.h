@@ -0,0 +1,54 @@
+/**********************************
+ * FILE NAME: Coalescer.h
+ *
+ * DESCRIPTION: Header file of Coalescer class
+ **********************************/
+
+#ifndef _COALESCER_H_
+#define _COALESCER_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+#include "MessageCodec.h"
+#include "Transport.h"
+
+/**
+ * STRUCT NAME: coalesce_frame
+ *
+ * DESCRIPTION: Messages waiting for one destination, framed as a BATCH
+ */
+typedef struct coalesce_frame {
+	Address to;
+	// BATCH header followed by the length-prefixed messages
+	vector<char> buf;
+	int count;
+}coalesce_frame;
+
+/**
+ * CLASS NAME: Coalescer
+ *
+ * DESCRIPTION: Outgoing batcher in front of the transport. Messages added for
+ * 				a destination are framed into one BATCH envelope, sent by flush,
+ * 				or earlier when the next message would take the envelope past
+ * 				the transport's largest payload. A frame holding a single message
+ * 				is sent as that message, so a lone message costs nothing extra
+ * 				and one of the largest size still goes through.
+ * 				Frames are sent in the order their destinations were first added.
+ */
+class Coalescer {
+private:
+	vector<coalesce_frame> frames;
+	// frames in use this step
+	int used;
+	// frame of each destination this step, by packed address key
+	unordered_map<long, int> frameOf;
+	void send(Transport *net, Address *from, coalesce_frame &frame);
+public:
+	Coalescer(): used(0) {}
+	void add(Transport *net, Address *from, Address *to, char *data, int size);
+	bool has(Address *to);
+	void flush(Transport *net, Address *from);
+	static bool unpack(char *data, int size, vector< pair<char *, int> > &out);
+};
+
+#endif /* _COALESCER_H_ */
@@ -0,0 +1,124 @@
+/**********************************
+ * FILE NAME: Dissemination.cpp
+ *
+ * DESCRIPTION: Definition of DisseminationBuffer class
+ **********************************/
+
+#include "Dissemination.h"
+
+/**
+ * FUNCTION NAME: push
+ *
+ * DESCRIPTION: Queue an event about a member, replacing any pending event
+ * 				about the same member. The new event has never been sent, so
+ * 				it goes first.
+ */
+void DisseminationBuffer::push(MemberListEntry *e) {
+	long key = Address::makeKey(e->id, e->port);
+	int s;
+	unordered_map<long, int>::iterator it = slotOf.find(key);
+	if ( it != slotOf.end() ) {
+		s = it->second;
+		slots[s].gen++;
+	}
+	else if ( !freeSlots.empty() ) {
+		s = freeSlots.back();
+		freeSlots.pop_back();
+		slots[s].gen++;
+		slotOf[key] = s;
+	}
+	else {
+		s = slots.size();
+		slots.push_back(dissemination_item());
+		slots[s].gen = 0;
+		slotOf[key] = s;
+	}
+	slots[s].entry = *e;
+	slots[s].sent = 0;
+	if ( buckets.empty() ) {
+		buckets.resize(1);
+	}
+	buckets[0].push_front(make_pair(s, slots[s].gen));
+}
+
+/**
+ * FUNCTION NAME: fill
+ *
+ * DESCRIPTION: Append the least sent events to a message until it is full or
+ * 				no event is left, then drop the events sent limit times. The
+ * 				events sent go behind the others of their new count, so that
+ * 				among equals the ones left out go next time.
+ *
+ * RETURNS:
+ * number of events appended
+ */
+int DisseminationBuffer::fill(MessageWriter *writer, int limit) {
+	bool full = false;
+	justSent.clear();
+	for ( int c = 0; c < (int)buckets.size() && !full; c++ ) {
+		deque< pair<int, int> > &bucket = buckets[c];
+		while ( !bucket.empty() ) {
+			int s = bucket.front().first;
+			if ( bucket.front().second != slots[s].gen ) {
+				bucket.pop_front();
+				continue;
+			}
+			if ( !writer->append(&slots[s].entry) ) {
+				full = true;
+				break;
+			}
+			bucket.pop_front();
+			slots[s].sent++;
+			justSent.push_back(make_pair(s, slots[s].gen));
+		}
+	}
+	for ( pair<int, int> &ref : justSent ) {
+		int s = ref.first;
+		if ( slots[s].sent >= limit ) {
+			slotOf.erase(Address::makeKey(slots[s].entry.id, slots[s].entry.port));
+			slots[s].gen++;
+			freeSlots.push_back(s);
+			continue;
+		}
+		if ( slots[s].sent >= (int)buckets.size() ) {
+			buckets.resize(slots[s].sent + 1);
+		}
+		buckets[slots[s].sent].push_back(ref);
+	}
+	return justSent.size();
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Number of pending events
+ */
+int DisseminationBuffer::size() {
+	return slotOf.size();
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Drop every pending event
+ */
+void DisseminationBuffer::clear() {
+	slots.clear();
+	freeSlots.clear();
+	slotOf.clear();
+	buckets.clear();
+}
+
+/**
+ * FUNCTION NAME: transmitLimit
+ *
+ * DESCRIPTION: Times an event is sent in a group of groupSize: lambda * ceil(log2(groupSize)),
+ * 				at least once
+ */
+int DisseminationBuffer::transmitLimit(int lambda, int groupSize) {
+	int bits = 0;
+	while ( (1L << bits) < (long)groupSize ) {
+		bits++;
+	}
+	return max(1, lambda * bits);
+}
@@ -0,0 +1,62 @@
+/**********************************
+ * FILE NAME: Dissemination.h
+ *
+ * DESCRIPTION: Header file of DisseminationBuffer class
+ **********************************/
+
+#ifndef _DISSEMINATION_H_
+#define _DISSEMINATION_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+#include "MessageCodec.h"
+
+/**
+ * STRUCT NAME: dissemination_item
+ *
+ * DESCRIPTION: A membership event waiting to be piggybacked
+ */
+typedef struct dissemination_item {
+	// the member as it was when the event was pushed, state included
+	MemberListEntry entry;
+	// messages it has been piggybacked on so far
+	int sent;
+	// bumped whenever the slot is reused or its event replaced, so that
+	// bucket references to the previous event can be told apart
+	int gen;
+}dissemination_item;
+
+/**
+ * CLASS NAME: DisseminationBuffer
+ *
+ * DESCRIPTION: Per-node queue of membership events (join, suspect, failed)
+ * 				piggybacked on outgoing messages. Each message takes the events
+ * 				sent the fewest times first, as many as fit in it, and an event
+ * 				is dropped once it has been sent limit times. With a limit of
+ * 				lambda * log(N) an event reaches the whole group with high
+ * 				probability, while messages stay bounded by the writer's
+ * 				capacity whatever the group size.
+ *
+ * 				Events live in stable slots. buckets[c] lists, as (slot, gen)
+ * 				pairs, the events sent c times in the order they should go;
+ * 				a pair whose gen no longer matches its slot is stale and skipped.
+ * 				Push and each event sent are O(1).
+ */
+class DisseminationBuffer {
+private:
+	vector<dissemination_item> slots;
+	vector<int> freeSlots;
+	// slot of the pending event about each member, by packed address key
+	unordered_map<long, int> slotOf;
+	vector< deque< pair<int, int> > > buckets;
+	// events sent by the current fill, moved up a bucket once it is done
+	vector< pair<int, int> > justSent;
+public:
+	void push(MemberListEntry *e);
+	int fill(MessageWriter *writer, int limit);
+	int size();
+	void clear();
+	static int transmitLimit(int lambda, int groupSize);
+};
+
+#endif /* _DISSEMINATION_H_ */
@@ -9,19 +9,23 @@
 /**
  * Constructor
  */
-EmulNet::EmulNet(Params *p)
+EmulNet::EmulNet(Params *p): links(p)
 {
 	//trace.funcEntry("EmulNet::EmulNet");
-	int i,j;
 	par = p;
 	emulnet.setNextId(1);
 	emulnet.settCurrBuffSize(0);
 	enInited=0;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			sent_msgs[i][j] = 0;
-			recv_msgs[i][j] = 0;
-		}
+	totalSent = 0;
+	totalRecv = 0;
+	totalBytes = 0;
+	overflowDrops = 0;
+	oversizeDrops = 0;
+	staging = false;
+	pendingSeq = 0;
+	totalDelay = 0;
+	for ( int w = 0; w < max(1, par->THREADS); w++ ) {
+		pools.push_back(new BufferPool);
 	}
 	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
@@ -29,92 +33,334 @@ EmulNet::EmulNet(Params *p)
 /**
  * Copy constructor
  */
-EmulNet::EmulNet(EmulNet &anotherEmulNet) {
-	int i, j;
+EmulNet::EmulNet(EmulNet &anotherEmulNet): links(anotherEmulNet.links) {
 	this->par = anotherEmulNet.par;
 	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
-	}
+	this->sent_msgs = anotherEmulNet.sent_msgs;
+	this->recv_msgs = anotherEmulNet.recv_msgs;
+	this->totalSent = anotherEmulNet.totalSent.load();
+	this->totalRecv = anotherEmulNet.totalRecv.load();
+	this->totalBytes = anotherEmulNet.totalBytes.load();
+	this->overflowDrops = anotherEmulNet.overflowDrops.load();
+	this->oversizeDrops = anotherEmulNet.oversizeDrops.load();
 	this->emulnet = anotherEmulNet.emulnet;
+	this->dropRng = anotherEmulNet.dropRng;
+	this->staging = false;
+	this->staged.resize(anotherEmulNet.staged.size());
+	this->pendingSeq = 0;
+	this->totalDelay = 0;
+	for ( int w = 0; w < max(1, par->THREADS); w++ ) {
+		this->pools.push_back(new BufferPool);
+	}
 }
 
 /**
  * Assignment operator overloading
  */
 EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet) {
-	int i, j;
 	this->par = anotherEmulNet.par;
 	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
-	}
+	this->sent_msgs = anotherEmulNet.sent_msgs;
+	this->recv_msgs = anotherEmulNet.recv_msgs;
+	this->totalSent = anotherEmulNet.totalSent.load();
+	this->totalRecv = anotherEmulNet.totalRecv.load();
+	this->totalBytes = anotherEmulNet.totalBytes.load();
+	this->overflowDrops = anotherEmulNet.overflowDrops.load();
+	this->oversizeDrops = anotherEmulNet.oversizeDrops.load();
 	this->emulnet = anotherEmulNet.emulnet;
+	this->dropRng = anotherEmulNet.dropRng;
+	this->links = anotherEmulNet.links;
 	return *this;
 }
 
 /**
  * Destructor
  */
-EmulNet::~EmulNet() {}
+EmulNet::~EmulNet() {
+	for ( BufferPool *pool : pools ) {
+		delete pool;
+	}
+}
 
 /**
  * FUNCTION NAME: ENinit
  *
- * DESCRIPTION: Init the emulnet for this node
+ * DESCRIPTION: Init the emulnet for this node.
+ * 				Everything indexed by node id is sized here, so that nodes never
+ * 				grow shared containers while they are stepped concurrently.
  */
 void *EmulNet::ENinit(Address *myaddr, short port) {
 	// Initialize data structures for this member
-	*(int *)(myaddr->addr) = emulnet.nextid++;
-    *(short *)(&myaddr->addr[4]) = 0;
+	int id = emulnet.nextid++;
+	*myaddr = Address(id, 0);
+	emulnet.getInbox(id);
+	if ( id >= (int)staged.size() ) {
+		staged.resize(id + 1);
+	}
+	if ( id >= (int)sent_msgs.size() ) {
+		sent_msgs.resize(id + 1);
+	}
+	if ( id >= (int)recv_msgs.size() ) {
+		recv_msgs.resize(id + 1);
+	}
+	seed_seq seq{par->SEED, (unsigned int)id};
+	while ( id >= (int)dropRng.size() ) {
+		dropRng.push_back(minstd_rand());
+	}
+	dropRng[id].seed(seq);
+	links.addNode(id);
 	return myaddr;
 }
 
 /**
  * FUNCTION NAME: ENsend
  *
- * DESCRIPTION: EmulNet send function
+ * DESCRIPTION: EmulNet send function.
+ * 				Oversize messages and random drops are decided here, from the
+ * 				sender's own drop generator. While staging the message is then
+ * 				held for ENflushStaged, otherwise it is delivered at once.
  *
  * RETURNS:
  * size
  */
 int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
 	en_msg *em;
-	static char temp[2048];
-	int sendmsg = rand() % 100;
+	long deliverAt;
 
-	if( (emulnet.currbuffsize >= ENBUFFSIZE) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+	// Loss from an oversize message is counted, not silent
+	if( size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE ) {
+		oversizeDrops++;
+		return 0;
+	}
+	if( !admit(myaddr->getId(), toaddr, size, &deliverAt) ) {
 		return 0;
 	}
 
-	em = (en_msg *)malloc(sizeof(en_msg) + size);
-	em->size = size;
+	em = (en_msg *)pools[ThreadPool::currentWorker()]->alloc(sizeof(en_msg) + sizeof(en_payload) + size);
+	em->payload = (en_payload *)(em + 1);
+	em->payload->refs = 1;
+	em->payload->block = em;
+	memcpy((char *)(em->payload + 1), data, size);
+	post(em, myaddr, toaddr, deliverAt, size);
+
+	return size;
+}
+
+/**
+ * FUNCTION NAME: ENsendBatch
+ *
+ * DESCRIPTION: Send the same message to count destinations.
+ * 				The payload is copied once and shared by refcount between the
+ * 				envelopes; drops are still decided per destination, in the order
+ * 				separate ENsend calls would decide them.
+ *
+ * RETURNS:
+ * number of destinations the message was accepted for
+ */
+int EmulNet::ENsendBatch(Address *myaddr, Address *toaddrs, int count, char *data, int size) {
+	BufferPool *pool = pools[ThreadPool::currentWorker()];
+	en_payload *shared = nullptr;
+	long deliverAt;
+	int accepted = 0;
+
+	if( size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE ) {
+		oversizeDrops += count;
+		return 0;
+	}
+	for ( int i = 0; i < count; i++ ) {
+		if( !admit(myaddr->getId(), &toaddrs[i], size, &deliverAt) ) {
+			continue;
+		}
+		// the payload is allocated with the first envelope; the reference held
+		// here keeps it alive while envelopes are delivered and consumed
+		if ( shared == nullptr ) {
+			shared = (en_payload *)pool->alloc(sizeof(en_payload) + size);
+			shared->refs = 1;
+			shared->block = shared;
+			memcpy((char *)(shared + 1), data, size);
+		}
+		en_msg *em = (en_msg *)pool->alloc(sizeof(en_msg));
+		em->payload = shared;
+		shared->refs++;
+		post(em, myaddr, &toaddrs[i], deliverAt, size);
+		accepted++;
+	}
+	if ( shared != nullptr ) {
+		unref(shared);
+	}
+
+	return accepted;
+}
+
+/**
+ * FUNCTION NAME: admit
+ *
+ * DESCRIPTION: Decide whether a message from node src reaches toaddr and when.
+ * 				With the event engine the message takes its place on the sender's
+ * 				egress link, and one that finds the backlog full is dropped like
+ * 				on a full buffer; then the random drop is drawn.
+ *
+ * RETURNS:
+ * false if the message is dropped
+ */
+bool EmulNet::admit(int src, Address *toaddr, int size, long *deliverAt) {
+	*deliverAt = par->getcurrtime() + 1;
+	if( deliveryListener && !links.schedule(src, toaddr->getId(), size, par->getcurrtime(), deliverAt) ) {
+		overflowDrops++;
+		return false;
+	}
+	if( par->dropmsg && (int)(dropRng[src]() % 100) < (int) (par->MSG_DROP_PROB * 100) ) {
+		return false;
+	}
+	return true;
+}
 
+/**
+ * FUNCTION NAME: post
+ *
+ * DESCRIPTION: Address an envelope and stage or deliver it
+ */
+void EmulNet::post(en_msg *em, Address *myaddr, Address *toaddr, long deliverAt, int size) {
+	em->size = size;
+	em->deliverAt = deliverAt;
 	memcpy(&(em->from.addr), &(myaddr->addr), sizeof(em->from.addr));
-	memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->from.addr));
-	memcpy(em + 1, data, size);
+	memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->to.addr));
 
-	emulnet.buff[emulnet.currbuffsize++] = em;
+	if ( staging ) {
+		staged[myaddr->getId()].push_back(em);
+	}
+	else {
+		deliver(em);
+	}
+}
 
-	int src = *(int *)(myaddr->addr);
-	int time = par->getcurrtime();
+/**
+ * FUNCTION NAME: deliver
+ *
+ * DESCRIPTION: Put a message in its destination inbox, or with the event engine
+ * 				hold it until its delivery time, and count it; or count it as an
+ * 				overflow drop if EN_BUFFSIZE messages are already in flight.
+ * 				Safe to call concurrently for different senders; the EN_BUFFSIZE
+ * 				bound is then only approximate.
+ */
+void EmulNet::deliver(en_msg *em) {
+	if( par->EN_BUFFSIZE > 0 && emulnet.currbuffsize >= par->EN_BUFFSIZE ) {
+		overflowDrops++;
+		discard(em);
+		return;
+	}
+
+	if ( deliveryListener ) {
+		en_pending p = {em->deliverAt, pendingSeq++, em};
+		pending.push(p);
+		totalDelay += em->deliverAt - par->getcurrtime();
+		deliveryListener(em->to.getId(), em->deliverAt);
+	}
+	else {
+		enqueue(em);
+	}
+	emulnet.currbuffsize++;
 
-	assert(src <= MAX_NODES);
-	assert(time < MAX_TIME);
+	countMsg(sent_msgs, em->from.getId(), par->getcurrtime());
+	totalSent++;
+	totalBytes += em->size;
+}
 
-	sent_msgs[src][time]++;
+/**
+ * FUNCTION NAME: enqueue
+ *
+ * DESCRIPTION: Push a message onto its destination inbox
+ */
+void EmulNet::enqueue(en_msg *em) {
+	atomic<en_msg*> &head = emulnet.getInbox(em->to.getId()).head;
+	em->next = head.load(memory_order_relaxed);
+	while ( !head.compare_exchange_weak(em->next, em, memory_order_release, memory_order_relaxed) ) {
+	}
+}
 
-	#ifdef DEBUGLOG
-		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)data, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
-	#endif
+/**
+ * FUNCTION NAME: discard
+ *
+ * DESCRIPTION: Free an envelope that will not be received, and its payload if
+ * 				nothing else uses it
+ */
+void EmulNet::discard(en_msg *em) {
+	en_payload *payload = em->payload;
+	if ( payload->block != em ) {
+		pools[ThreadPool::currentWorker()]->release(em);
+	}
+	unref(payload);
+}
 
-	return size;
+/**
+ * FUNCTION NAME: unref
+ *
+ * DESCRIPTION: Drop one reference to a payload, releasing it with the last one
+ */
+void EmulNet::unref(en_payload *payload) {
+	if ( --payload->refs == 0 ) {
+		pools[ThreadPool::currentWorker()]->release(payload->block);
+	}
+}
+
+/**
+ * FUNCTION NAME: ENsetDeliveryListener
+ *
+ * DESCRIPTION: Hand delivery timing over to the event engine. From now on each
+ * 				message is delivered when the LinkModel says, once ENdeliverDue
+ * 				reaches that time, and the listener is called with the
+ * 				destination node id and the delivery time as it is sent.
+ */
+void EmulNet::ENsetDeliveryListener(function<void(int, long)> listener) {
+	deliveryListener = listener;
+}
+
+/**
+ * FUNCTION NAME: ENdeliverDue
+ *
+ * DESCRIPTION: Move the held messages due by time into their inboxes, earliest
+ * 				first and in send order among equals
+ */
+void EmulNet::ENdeliverDue(long time) {
+	while ( !pending.empty() && pending.top().deliverAt <= time ) {
+		enqueue(pending.top().em);
+		pending.pop();
+	}
+}
+
+/**
+ * FUNCTION NAME: ENmaxPayload
+ *
+ * DESCRIPTION: Largest message ENsend accepts under MAX_MSG_SIZE
+ */
+int EmulNet::ENmaxPayload() {
+	return par->MAX_MSG_SIZE - (int)sizeof(en_msg) - 1;
+}
+
+/**
+ * FUNCTION NAME: ENsetStaging
+ *
+ * DESCRIPTION: Turn staging on or off. While on, ENsend only touches the
+ * 				sender's own state and may be called concurrently for different
+ * 				senders; messages reach the inboxes through ENflushStaged.
+ */
+void EmulNet::ENsetStaging(bool on) {
+	staging = on;
+}
+
+/**
+ * FUNCTION NAME: ENflushStaged
+ *
+ * DESCRIPTION: Deliver the messages staged by one sender, in the order it sent them.
+ * 				Flushing the senders in the order a serial run would have stepped
+ * 				them leaves the inboxes exactly as that run would.
+ */
+void EmulNet::ENflushStaged(Address *myaddr) {
+	vector<en_msg*> &out = staged[myaddr->getId()];
+	for ( en_msg *em : out ) {
+		deliver(em);
+	}
+	out.clear();
 }
 
 /**
@@ -126,56 +372,64 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
  * size
  */
 int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data) {
-	char * str = (char *) malloc(data.length() * sizeof(char));
-	memcpy(str, data.c_str(), data.size());
-	int ret = this->ENsend(myaddr, toaddr, str, (data.length() * sizeof(char)));
-	free(str);
-	return ret;
+	return this->ENsend(myaddr, toaddr, (char *)data.c_str(), (data.length() * sizeof(char)));
 }
 
 /**
  * FUNCTION NAME: ENrecv
  *
  * DESCRIPTION: EmulNet receive function
+ * 				The buffers handed to enq are the network buffers themselves; the
+ * 				receiver owns them and must give each back with ENrelease.
  *
  * RETURN:
  * 0
  */
 int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue){
 	// times is always assumed to be 1
-	int i;
-	char* tmp;
-	int sz;
-	en_msg *emsg;
-
-	for( i = emulnet.currbuffsize - 1; i >= 0; i-- ) {
-		emsg = emulnet.buff[i];
-
-		if ( 0 == strcmp(emsg->to.addr, myaddr->addr) ) {
-			sz = emsg->size;
-			tmp = (char *) malloc(sz * sizeof(char));
-			memcpy(tmp, (char *)(emsg+1), sz);
-
-			emulnet.buff[i] = emulnet.buff[emulnet.currbuffsize-1];
-			emulnet.currbuffsize--;
-
-			(*enq)(queue, (char *)tmp, sz);
-
-			free(emsg);
-
-			int dst = *(int *)(myaddr->addr);
-			int time = par->getcurrtime();
-
-			assert(dst <= MAX_NODES);
-			assert(time < MAX_TIME);
+	int dst = myaddr->getId();
+	int time = par->getcurrtime();
 
-			recv_msgs[dst][time]++;
+	// Only this node's inbox is visited; it is taken whole and reversed
+	// into the order messages were sent
+	en_msg *emsg = emulnet.getInbox(dst).head.exchange(nullptr, memory_order_acquire);
+	en_msg *ordered = nullptr;
+	while ( emsg != nullptr ) {
+		en_msg *next = emsg->next;
+		emsg->next = ordered;
+		ordered = emsg;
+		emsg = next;
+	}
+	// The receiver takes over the envelope's reference to the payload; an
+	// envelope that does not hold its payload is not needed past this point
+	int count = 0;
+	while ( ordered != nullptr ) {
+		emsg = ordered;
+		ordered = emsg->next;
+		(*enq)(queue, (char *)(emsg->payload + 1), emsg->size);
+		if ( emsg->payload->block != emsg ) {
+			pools[ThreadPool::currentWorker()]->release(emsg);
 		}
+
+		countMsg(recv_msgs, dst, time);
+		count++;
 	}
+	totalRecv += count;
+	emulnet.currbuffsize -= count;
 
 	return 0;
 }
 
+/**
+ * FUNCTION NAME: ENrelease
+ *
+ * DESCRIPTION: Give back a buffer received through ENrecv; the payload returns
+ * 				to the pool once every receiver of it has done so
+ */
+void EmulNet::ENrelease(char *data) {
+	unref((en_payload *)data - 1);
+}
+
 /**
  * FUNCTION NAME: ENcleanup
  *
@@ -183,38 +437,82 @@ int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct ti
  */
 int EmulNet::ENcleanup() {
 	emulnet.nextid=0;
-	int i, j;
-	int sent_total, recv_total;
-
-	FILE* file = fopen("msgcount.log", "w+");
 
-	while(emulnet.currbuffsize > 0) {
-		free(emulnet.buff[--emulnet.currbuffsize]);
+	for ( en_inbox &inbox : emulnet.inbox ) {
+		en_msg *emsg = inbox.head.exchange(nullptr);
+		while ( emsg != nullptr ) {
+			en_msg *next = emsg->next;
+			discard(emsg);
+			emsg = next;
+		}
 	}
-
-	for ( i = 1; i <= par->EN_GPSZ; i++ ) {
-		fprintf(file, "node %3d ", i);
-		sent_total = 0;
-		recv_total = 0;
-
-		for (j = 0; j < par->getcurrtime(); j++) {
-
-			sent_total += sent_msgs[i][j];
-			recv_total += recv_msgs[i][j];
-			if (i != 67) {
-				fprintf(file, " (%4d, %4d)", sent_msgs[i][j], recv_msgs[i][j]);
-				if (j % 10 == 9) {
-					fprintf(file, "\n         ");
-				}
-			}
-			else {
-				fprintf(file, "special %4d %4d %4d\n", j, sent_msgs[i][j], recv_msgs[i][j]);
-			}
+	for ( vector<en_msg*> &out : staged ) {
+		for ( en_msg *emsg : out ) {
+			discard(emsg);
 		}
-		fprintf(file, "\n");
-		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n\n", i, sent_total, recv_total);
+		out.clear();
+	}
+	while ( !pending.empty() ) {
+		discard(pending.top().em);
+		pending.pop();
 	}
+	emulnet.currbuffsize = 0;
 
-	fclose(file);
+	writeMsgCount(par);
 	return 0;
 }
+
+/**
+ * FUNCTION NAME: getTotalSent
+ *
+ * DESCRIPTION: Number of messages accepted by ENsend so far
+ */
+long EmulNet::getTotalSent() {
+	return totalSent;
+}
+
+/**
+ * FUNCTION NAME: getTotalRecv
+ *
+ * DESCRIPTION: Number of messages handed out by ENrecv so far
+ */
+long EmulNet::getTotalRecv() {
+	return totalRecv;
+}
+
+/**
+ * FUNCTION NAME: getTotalBytes
+ *
+ * DESCRIPTION: Payload bytes of the messages accepted by ENsend so far
+ */
+long EmulNet::getTotalBytes() {
+	return totalBytes;
+}
+
+/**
+ * FUNCTION NAME: getOverflowDrops
+ *
+ * DESCRIPTION: Number of messages refused because the buffer was full
+ */
+long EmulNet::getOverflowDrops() {
+	return overflowDrops;
+}
+
+/**
+ * FUNCTION NAME: getOversizeDrops
+ *
+ * DESCRIPTION: Number of messages refused because they exceed MAX_MSG_SIZE
+ */
+long EmulNet::getOversizeDrops() {
+	return oversizeDrops;
+}
+
+/**
+ * FUNCTION NAME: getMeanDelay
+ *
+ * DESCRIPTION: Mean time units from send to delivery of the messages held for
+ * 				the event engine, 0 if none
+ */
+double EmulNet::getMeanDelay() {
+	return pendingSeq > 0 ? (double)totalDelay / pendingSeq : 0;
+}
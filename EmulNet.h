@@ -7,18 +7,24 @@
 #ifndef _EMULNET_H_
 #define _EMULNET_H_
 
-#define MAX_NODES 1000
-#define MAX_TIME 3600
-#define ENBUFFSIZE 30000
-
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "BufferPool.h"
+#include "ThreadPool.h"
+#include "Transport.h"
+#include "LinkModel.h"
 
 using namespace std;
 
+struct en_payload;
+
 /**
  * Struct Name: en_msg
+ *
+ * DESCRIPTION: Envelope of a message to one destination. A unicast message
+ * 				carries its payload right after the envelope; the envelopes of
+ * 				an ENsendBatch share one payload allocated on its own.
  */
 typedef struct en_msg {
 	// Number of bytes after the class
@@ -27,29 +33,95 @@ typedef struct en_msg {
 	Address from;
 	// Destination node
 	Address to;
+	// Next message in the destination inbox, see en_inbox
+	struct en_msg *next;
+	// time at which the message reaches the destination inbox
+	long deliverAt;
+	// payload handed to the receiver
+	struct en_payload *payload;
 }en_msg;
 
+/**
+ * Struct Name: en_payload
+ *
+ * DESCRIPTION: Header in front of the payload bytes. refs counts the envelopes
+ * 				and receivers still using them; the last one to let go releases
+ * 				block, the allocation holding the payload.
+ */
+typedef struct en_payload {
+	atomic<int> refs;
+	void *block;
+}en_payload;
+
+/**
+ * Struct Name: en_pending
+ *
+ * DESCRIPTION: A message held by the event engine until its delivery time.
+ * 				seq keeps messages due at the same time in the order they were sent.
+ */
+typedef struct en_pending {
+	long deliverAt;
+	long seq;
+	en_msg *em;
+}en_pending;
+
+/**
+ * STRUCT NAME: PendingLater
+ *
+ * DESCRIPTION: Orders a priority_queue of en_pending earliest delivery first
+ */
+struct PendingLater {
+	bool operator()(const en_pending &a, const en_pending &b) const {
+		return a.deliverAt != b.deliverAt ? a.deliverAt > b.deliverAt : a.seq > b.seq;
+	}
+};
+
+/**
+ * Struct Name: en_inbox
+ *
+ * DESCRIPTION: Lock-free multi-producer, single-consumer inbox of one node.
+ * 				Senders push onto the head with compare-and-swap; the owner takes
+ * 				the whole list with one exchange and reverses it, getting the
+ * 				messages in the order they were pushed.
+ */
+typedef struct en_inbox {
+	// most recently pushed message, NULL if empty
+	atomic<en_msg*> head;
+	en_inbox(): head(nullptr) {}
+	en_inbox(const en_inbox &anotherInbox): head(anotherInbox.head.load()) {}
+	en_inbox& operator =(const en_inbox &anotherInbox) {
+		head.store(anotherInbox.head.load());
+		return *this;
+	}
+}en_inbox;
+
 /**
  * Class Name: EM
+ *
+ * DESCRIPTION: Messages in flight, kept in one inbox per destination node id.
+ * 				currbuffsize counts the messages across all inboxes; it is atomic
+ * 				because nodes receive concurrently when THREADS > 1.
  */
 class EM {
 public:
 	int nextid;
-	int currbuffsize;
+	atomic<int> currbuffsize;
 	int firsteltindex;
-	en_msg* buff[ENBUFFSIZE];
+	vector<en_inbox> inbox;
 	EM() {}
 	EM& operator = (EM &anotherEM) {
 		this->nextid = anotherEM.getNextId();
 		this->currbuffsize = anotherEM.getCurrBuffSize();
 		this->firsteltindex = anotherEM.getFirstEltIndex();
-		int i = this->currbuffsize;
-		while (i > 0) {
-			this->buff[i] = anotherEM.buff[i];
-			i--;
-		}
+		this->inbox = anotherEM.inbox;
 		return *this;
 	}
+	en_inbox& getInbox(int id) {
+		if ( id >= (int)inbox.size() ) {
+			inbox.resize(id + 1);
+		}
+		return inbox[id];
+	}
 	int getNextId() {
 		return nextid;
 	}
@@ -74,16 +146,44 @@ public:
 /**
  * CLASS NAME: EmulNet
  *
- * DESCRIPTION: This class defines an emulated network
+ * DESCRIPTION: This class defines an emulated network, the default Transport
  */
-class EmulNet
+class EmulNet: public Transport
 { 	
 private:
 	Params* par;
-	int sent_msgs[MAX_NODES + 1][MAX_TIME];
-	int recv_msgs[MAX_NODES + 1][MAX_TIME];
+	atomic<long> totalSent;
+	atomic<long> totalRecv;
+	// payload bytes of the messages accepted by ENsend
+	atomic<long> totalBytes;
+	// messages refused because EN_BUFFSIZE messages were already in flight
+	atomic<long> overflowDrops;
+	// messages refused because they exceed MAX_MSG_SIZE
+	atomic<long> oversizeDrops;
 	int enInited;
 	EM emulnet;
+	// one pool per worker thread, indexed by ThreadPool::currentWorker()
+	vector<BufferPool *> pools;
+	// per-sender drop decisions, seeded from SEED and the sender id
+	vector<minstd_rand> dropRng;
+	// while staging, messages are held per sender id until ENflushStaged
+	bool staging;
+	vector< vector<en_msg*> > staged;
+	// with the event engine, messages wait here until their delivery time and
+	// the listener is told which node to wake and when
+	function<void(int, long)> deliveryListener;
+	priority_queue<en_pending, vector<en_pending>, PendingLater> pending;
+	long pendingSeq;
+	// delay and egress capacity of each link, used with the event engine
+	LinkModel links;
+	// sum of the delays of the messages held, for getMeanDelay
+	long totalDelay;
+	bool admit(int src, Address *toaddr, int size, long *deliverAt);
+	void post(en_msg *em, Address *myaddr, Address *toaddr, long deliverAt, int size);
+	void deliver(en_msg *em);
+	void enqueue(en_msg *em);
+	void discard(en_msg *em);
+	void unref(en_payload *payload);
 public:
  	EmulNet(Params *p);
  	EmulNet(EmulNet &anotherEmulNet);
@@ -92,8 +192,21 @@ public:
 	void *ENinit(Address *myaddr, short port);
 	int ENsend(Address *myaddr, Address *toaddr, string data);
 	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
+	int ENsendBatch(Address *myaddr, Address *toaddrs, int count, char *data, int size);
 	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
+	void ENrelease(char *data);
+	int ENmaxPayload();
+	void ENsetStaging(bool on);
+	void ENflushStaged(Address *myaddr);
+	void ENsetDeliveryListener(function<void(int, long)> listener);
+	void ENdeliverDue(long time);
 	int ENcleanup();
+	long getTotalSent();
+	long getTotalRecv();
+	long getTotalBytes();
+	long getOverflowDrops();
+	long getOversizeDrops();
+	double getMeanDelay();
 };
 
 #endif /* _EMULNET_H_ */
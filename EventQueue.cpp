@@ -0,0 +1,80 @@
+/**********************************
+ * FILE NAME: EventQueue.cpp
+ *
+ * DESCRIPTION: Definition of EventQueue class
+ **********************************/
+
+#include "EventQueue.h"
+
+/**
+ * Constructor
+ */
+EventQueue::EventQueue(int nodes): wakeAt(nodes, -1), seq(0) {}
+
+/**
+ * FUNCTION NAME: wake
+ *
+ * DESCRIPTION: Step node at time, unless it is already woken no later
+ */
+void EventQueue::wake(int node, long time) {
+	if ( wakeAt[node] >= 0 && wakeAt[node] <= time ) {
+		return;
+	}
+	wakeAt[node] = time;
+	sim_event e = {time, seq++, NODE_WAKEUP, node};
+	events.push(e);
+}
+
+/**
+ * FUNCTION NAME: control
+ *
+ * DESCRIPTION: Run the failure and message drop controls at time
+ */
+void EventQueue::control(long time) {
+	sim_event e = {time, seq++, CONTROL_EVENT, -1};
+	events.push(e);
+}
+
+/**
+ * FUNCTION NAME: empty
+ *
+ * DESCRIPTION: Return true if no event is left
+ */
+bool EventQueue::empty() {
+	return events.empty();
+}
+
+/**
+ * FUNCTION NAME: nextTime
+ *
+ * DESCRIPTION: Time of the earliest event; the queue must not be empty
+ */
+long EventQueue::nextTime() {
+	return events.top().time;
+}
+
+/**
+ * FUNCTION NAME: popDue
+ *
+ * DESCRIPTION: Take every event due by time. The nodes to step are left in
+ * 				nodes, each once; superseded wakeups are dropped.
+ *
+ * RETURNS:
+ * true if a control event was due
+ */
+bool EventQueue::popDue(long time, vector<int> &nodes) {
+	bool control = false;
+	nodes.clear();
+	while ( !events.empty() && events.top().time <= time ) {
+		sim_event e = events.top();
+		events.pop();
+		if ( e.type == CONTROL_EVENT ) {
+			control = true;
+		}
+		else if ( wakeAt[e.node] == e.time ) {
+			wakeAt[e.node] = -1;
+			nodes.push_back(e.node);
+		}
+	}
+	return control;
+}
@@ -0,0 +1,69 @@
+/**********************************
+ * FILE NAME: EventQueue.h
+ *
+ * DESCRIPTION: Header file of EventQueue class, the schedule of the
+ * 				discrete-event engine
+ **********************************/
+
+#ifndef _EVENTQUEUE_H_
+#define _EVENTQUEUE_H_
+
+#include "stdincludes.h"
+
+/*
+ * Event types
+ */
+enum SimEventTypes {
+	// step a node: start it, or let it receive and handle messages and timers
+	NODE_WAKEUP,
+	// let Application::fail fail nodes or toggle message drops
+	CONTROL_EVENT
+};
+
+/**
+ * STRUCT NAME: sim_event
+ *
+ * DESCRIPTION: An event of the engine; seq orders events of the same time
+ */
+typedef struct sim_event {
+	long time;
+	long seq;
+	enum SimEventTypes type;
+	int node;
+}sim_event;
+
+/**
+ * STRUCT NAME: EventLater
+ *
+ * DESCRIPTION: Orders a priority_queue of sim_event earliest first
+ */
+struct EventLater {
+	bool operator()(const sim_event &a, const sim_event &b) const {
+		return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+	}
+};
+
+/**
+ * CLASS NAME: EventQueue
+ *
+ * DESCRIPTION: Time-ordered events of the discrete-event engine. A node needs
+ * 				only its earliest wakeup: an earlier one supersedes the one
+ * 				pending, which is then skipped, since the node tells the engine
+ * 				its next wakeup again each time it is stepped.
+ */
+class EventQueue {
+private:
+	priority_queue<sim_event, vector<sim_event>, EventLater> events;
+	// pending wakeup of each node, -1 if none
+	vector<long> wakeAt;
+	long seq;
+public:
+	EventQueue(int nodes);
+	void wake(int node, long time);
+	void control(long time);
+	bool empty();
+	long nextTime();
+	bool popDue(long time, vector<int> &nodes);
+};
+
+#endif /* _EVENTQUEUE_H_ */
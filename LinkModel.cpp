@@ -0,0 +1,102 @@
+/**********************************
+ * FILE NAME: LinkModel.cpp
+ *
+ * DESCRIPTION: Definition of LinkModel class
+ **********************************/
+
+#include "LinkModel.h"
+
+/**
+ * Constructor
+ */
+LinkModel::LinkModel(Params *par): par(par) {}
+
+/**
+ * FUNCTION NAME: addNode
+ *
+ * DESCRIPTION: Set up the link state of node id
+ */
+void LinkModel::addNode(int id) {
+	if ( id >= (int)delayRng.size() ) {
+		delayRng.resize(id + 1);
+		egressFree.resize(id + 1, 0);
+	}
+	seed_seq seq{par->SEED, (unsigned int)id, 1u};
+	delayRng[id].seed(seq);
+}
+
+/**
+ * FUNCTION NAME: racks
+ *
+ * DESCRIPTION: Number of racks across all zones
+ */
+int LinkModel::racks() {
+	return max(1, par->ZONES) * max(1, par->RACKS_PER_ZONE);
+}
+
+/**
+ * FUNCTION NAME: rackOf
+ *
+ * DESCRIPTION: Rack of node id, numbered across zones
+ */
+int LinkModel::rackOf(int id) {
+	return (id - 1) % racks();
+}
+
+/**
+ * FUNCTION NAME: zoneOf
+ *
+ * DESCRIPTION: Zone of node id
+ */
+int LinkModel::zoneOf(int id) {
+	return rackOf(id) / max(1, par->RACKS_PER_ZONE);
+}
+
+/**
+ * FUNCTION NAME: baseDelay
+ *
+ * DESCRIPTION: Delay of the link from one node to another before jitter, at
+ * 				least one time unit. An unset RACK_LATENCY or ZONE_LATENCY takes
+ * 				the delay of the closer link class.
+ */
+long LinkModel::baseDelay(int from, int to) {
+	long rack = max(1, par->LATENCY);
+	long cross = par->RACK_LATENCY > 0 ? par->RACK_LATENCY : rack;
+	long zone = par->ZONE_LATENCY > 0 ? par->ZONE_LATENCY : cross;
+	if ( zoneOf(from) != zoneOf(to) ) {
+		return zone;
+	}
+	if ( rackOf(from) != rackOf(to) ) {
+		return cross;
+	}
+	return rack;
+}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Put a message of size payload bytes sent at time now on the
+ * 				sender's egress link and compute when it reaches the receiver:
+ * 				the time its transmission ends, plus the link delay.
+ *
+ * RETURNS:
+ * false if the egress backlog is full and the message is dropped
+ */
+bool LinkModel::schedule(int from, int to, int size, long now, long *deliverAt) {
+	double departure = now;
+	if ( par->EGRESS_BYTES > 0 ) {
+		double start = max(egressFree[from], (double)now);
+		if ( par->EGRESS_BACKLOG > 0 && start - now >= par->EGRESS_BACKLOG ) {
+			return false;
+		}
+		egressFree[from] = start + (double)size / par->EGRESS_BYTES;
+		departure = egressFree[from];
+	}
+	long delay = baseDelay(from, to);
+	if ( par->JITTER > 0 ) {
+		exponential_distribution<double> jitter(1.0 / (par->JITTER * delay));
+		delay += (long)(jitter(delayRng[from]) + 0.5);
+	}
+	*deliverAt = (long)departure + delay;
+	return true;
+}
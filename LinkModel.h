@@ -0,0 +1,43 @@
+/**********************************
+ * FILE NAME: LinkModel.h
+ *
+ * DESCRIPTION: Header file of LinkModel class
+ **********************************/
+
+#ifndef _LINKMODEL_H_
+#define _LINKMODEL_H_
+
+#include "stdincludes.h"
+#include "Params.h"
+
+/**
+ * CLASS NAME: LinkModel
+ *
+ * DESCRIPTION: Delay and capacity of the links between EmulNet nodes.
+ * 				Nodes are placed round-robin over ZONES * RACKS_PER_ZONE racks.
+ * 				A link's base delay is LATENCY within a rack, RACK_LATENCY
+ * 				across racks of a zone and ZONE_LATENCY across zones, plus an
+ * 				exponentially distributed jitter with mean JITTER times the base.
+ * 				With EGRESS_BYTES set, each node sends that many payload bytes per
+ * 				time unit and later messages queue behind earlier ones; a message
+ * 				that would wait EGRESS_BACKLOG time units or more is dropped.
+ * 				Random draws come from a per-sender generator seeded from SEED.
+ */
+class LinkModel {
+private:
+	Params *par;
+	// indexed by node id
+	vector<minstd_rand> delayRng;
+	// time at which each node's egress link is next free
+	vector<double> egressFree;
+	int racks();
+public:
+	LinkModel(Params *par);
+	void addNode(int id);
+	int rackOf(int id);
+	int zoneOf(int id);
+	long baseDelay(int from, int to);
+	bool schedule(int from, int to, int size, long now, long *deliverAt);
+};
+
+#endif /* _LINKMODEL_H_ */
@@ -12,6 +12,8 @@
 Log::Log(Params *p) {
 	par = p;
 	firstTime = false;
+	staging = false;
+	staged.resize(par->EN_GPSZ + 1);
 }
 
 /**
@@ -20,6 +22,8 @@ Log::Log(Params *p) {
 Log::Log(const Log &anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	this->staging = anotherLog.staging;
+	this->staged = anotherLog.staged;
 }
 
 /**
@@ -28,6 +32,8 @@ Log::Log(const Log &anotherLog) {
 Log& Log::operator = (const Log& anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	this->staging = anotherLog.staging;
+	this->staged = anotherLog.staged;
 	return *this;
 }
 
@@ -43,89 +49,184 @@ Log::~Log() {}
  */
 void Log::LOG(Address *addr, const char * str, ...) {
 
-	static FILE *fp;
-	static FILE *fp2;
+	static atomic<bool> dbg_opened(false);
 	va_list vararglist;
-	static char buffer[30000];
-	static int numwrites;
-	static char stdstring[30];
-	static char stdstring2[40];
-	static char stdstring3[40]; 
-	static int dbg_opened=0;
+	char buffer[LOG_LINE_SIZE];
+	LogWriter *writer = LogWriter::getInstance(DBG_LOG, STATS_LOG);
 
-	if(dbg_opened != 639){
-		numwrites=0;
-
-		stdstring2[0]=0;
-
-		strcpy(stdstring3, stdstring2);
-
-		strcat(stdstring2, DBG_LOG);
-		strcat(stdstring3, STATS_LOG);
-
-		fp = fopen(stdstring2, "w");
-		fp2 = fopen(stdstring3, "w");
-
-		dbg_opened=639;
-	}
-	else 
-
-	sprintf(stdstring, "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], *(short *)&addr->addr[4]);
+	// The very first line of a run has always been written without an address
+	bool firstLine = !dbg_opened.exchange(true);
 
 	va_start(vararglist, str);
-	vsprintf(buffer, str, vararglist);
+	vsnprintf(buffer, sizeof(buffer), str, vararglist);
 	va_end(vararglist);
 
 	if (!firstTime) {
 		int magicNumber = 0;
+		char magicLine[16];
 		string magic = MAGIC_NUMBER;
 		int len = magic.length();
 		for ( int i = 0; i < len; i++ ) {
 			magicNumber += (int)magic.at(i);
 		}
-		fprintf(fp, "%x\n", magicNumber);
+		sprintf(magicLine, "%x\n", magicNumber);
+		writer->appendRaw(LOG_DBG, magicLine);
 		firstTime = true;
 	}
 
-	if(memcmp(buffer, "#STATSLOG#", 10)==0){
-		fprintf(fp2, "\n %s", stdstring);
-		fprintf(fp2, "[%d] ", par->getcurrtime());
-
-		fprintf(fp2, buffer);
+	int file = (memcmp(buffer, "#STATSLOG#", 10)==0) ? LOG_STATS : LOG_DBG;
+	int id = addr->getId();
+	if ( staging && id >= 0 && id < (int)staged.size() ) {
+		staged[id].emplace_back();
+		staged_line &line = staged[id].back();
+		line.file = file;
+		line.hasAddr = !firstLine;
+		line.addr = *addr;
+		line.time = par->getcurrtime();
+		line.body = buffer;
 	}
-	else{
-		fprintf(fp, "\n %s", stdstring);
-		fprintf(fp, "[%d] ", par->getcurrtime());
-		fprintf(fp, buffer);
-
+	else {
+		writer->append(file, firstLine ? nullptr : addr, par->getcurrtime(), buffer);
 	}
 
-	if(++numwrites >= MAXWRITES){
-		fflush(fp);
-		fflush(fp2);
-		numwrites=0;
+}
+
+/**
+ * FUNCTION NAME: setStaging
+ *
+ * DESCRIPTION: Turn staging on or off. While on, each line is held under the
+ * 				node id of its address, so that nodes stepped concurrently can
+ * 				log without their lines interleaving.
+ */
+void Log::setStaging(bool on) {
+	staging = on;
+}
+
+/**
+ * FUNCTION NAME: flushStaged
+ *
+ * DESCRIPTION: Hand the lines staged by one node to the writer, in the order they were logged
+ */
+void Log::flushStaged(Address *addr) {
+	vector<staged_line> &lines = staged[addr->getId()];
+	LogWriter *writer = LogWriter::getInstance(DBG_LOG, STATS_LOG);
+	for ( staged_line &line : lines ) {
+		writer->append(line.file, line.hasAddr ? &line.addr : nullptr, line.time, line.body.c_str());
 	}
+	lines.clear();
+}
 
+/**
+ * FUNCTION NAME: flush
+ *
+ * DESCRIPTION: Block until every line logged so far is in the files
+ */
+void Log::flush() {
+	LogWriter::getInstance(DBG_LOG, STATS_LOG)->flush();
+}
+
+/**
+ * FUNCTION NAME: workerLogName
+ *
+ * DESCRIPTION: Name of a log file of one worker process, e.g. dbg.log.3
+ */
+static string workerLogName(const char *base, int worker) {
+	return string(base) + "." + to_string(worker);
+}
+
+/**
+ * FUNCTION NAME: startWorker
+ *
+ * DESCRIPTION: In a forked worker process, send the log to files of its own
+ */
+void Log::startWorker(int worker) {
+	LogWriter::reopen(workerLogName(DBG_LOG, worker).c_str(), workerLogName(STATS_LOG, worker).c_str());
+}
+
+/**
+ * FUNCTION NAME: finishWorker
+ *
+ * DESCRIPTION: In a worker process, write out and close its log files
+ */
+void Log::finishWorker() {
+	LogWriter::getInstance(DBG_LOG, STATS_LOG)->shutdown();
+}
+
+/**
+ * FUNCTION NAME: mergeWorkers
+ *
+ * DESCRIPTION: Append the logs of the worker processes to this process's log
+ * 				and remove them. Each worker's lines are in time order; they are
+ * 				merged by the time stamp, earlier workers first on ties.
+ */
+void Log::mergeWorkers(int workers) {
+	LogWriter *writer = LogWriter::getInstance(DBG_LOG, STATS_LOG);
+	const char *bases[2] = { DBG_LOG, STATS_LOG };
+	int files[2] = { LOG_DBG, LOG_STATS };
+
+	for ( int f = 0; f < 2; f++ ) {
+		vector<ifstream *> in(workers);
+		vector<string> line(workers);
+		vector<int> time(workers, -1);
+		// read the next non-empty line of worker w, time -1 once it is exhausted
+		auto next = [&](int w) {
+			time[w] = -1;
+			while ( getline(*in[w], line[w]) ) {
+				size_t open = line[w].find('[');
+				if ( !line[w].empty() && open != string::npos ) {
+					time[w] = atoi(line[w].c_str() + open + 1);
+					return;
+				}
+			}
+		};
+		for ( int w = 0; w < workers; w++ ) {
+			in[w] = new ifstream(workerLogName(bases[f], w).c_str());
+			next(w);
+		}
+		while ( true ) {
+			int pick = -1;
+			for ( int w = 0; w < workers; w++ ) {
+				if ( time[w] >= 0 && (pick < 0 || time[w] < time[pick]) ) {
+					pick = w;
+				}
+			}
+			if ( pick < 0 ) {
+				break;
+			}
+			writer->appendRaw(files[f], ("\n" + line[pick]).c_str());
+			next(pick);
+		}
+		for ( int w = 0; w < workers; w++ ) {
+			delete in[w];
+			remove(workerLogName(bases[f], w).c_str());
+		}
+	}
 }
 
 /**
  * FUNCTION NAME: logNodeAdd
  *
- * DESCRIPTION: To Log a node add
+ * DESCRIPTION: To Log a node add. Skipped when QUIET_LOG is set.
  */
 void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
-	static char stdstring[100];
-	sprintf(stdstring, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], *(short *)&addedAddr->addr[4], par->getcurrtime());
+	char stdstring[100];
+	if ( par->QUIET_LOG ) {
+		return;
+	}
+	sprintf(stdstring, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], addedAddr->getPort(), par->getcurrtime());
     LOG(thisNode, stdstring);
 }
 
 /**
  * FUNCTION NAME: logNodeRemove
  *
- * DESCRIPTION: To log a node remove
+ * DESCRIPTION: To log a node remove. Skipped when QUIET_LOG is set.
  */
 void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
-	static char stdstring[30];
-	sprintf(stdstring, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], *(short *)&removedAddr->addr[4], par->getcurrtime());
+	char stdstring[100];
+	if ( par->QUIET_LOG ) {
+		return;
+	}
+	sprintf(stdstring, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], removedAddr->getPort(), par->getcurrtime());
     LOG(thisNode, stdstring);
 }
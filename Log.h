@@ -10,25 +10,46 @@
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "LogWriter.h"
 
 /*
  * Macros
  */
-// number of writes after which to flush file
-#define MAXWRITES 1
 #define MAGIC_NUMBER "CS425"
 #define DBG_LOG "dbg.log"
 #define STATS_LOG "stats.log"
+// longest line Log::LOG formats, longer ones are cut
+#define LOG_LINE_SIZE 30000
+
+/**
+ * STRUCT NAME: staged_line
+ *
+ * DESCRIPTION: A log line held back while staging, see Log::setStaging
+ */
+typedef struct staged_line {
+	// LOG_DBG or LOG_STATS
+	int file;
+	// false if the address prefix is left empty
+	bool hasAddr;
+	Address addr;
+	int time;
+	string body;
+}staged_line;
 
 /**
  * CLASS NAME: Log
  *
- * DESCRIPTION: Functions to log messages in a debug log
+ * DESCRIPTION: Functions to log messages in a debug log.
+ * 				Lines are queued to the asynchronous LogWriter, which writes
+ * 				them in batches and flushes everything at exit.
  */
 class Log{
 private:
 	Params *par;
 	bool firstTime;
+	// while staging, lines are held per logging node id until flushStaged
+	bool staging;
+	vector< vector<staged_line> > staged;
 public:
 	Log(Params *p);
 	Log(const Log &anotherLog);
@@ -37,6 +58,12 @@ public:
 	void LOG(Address *, const char * str, ...);
 	void logNodeAdd(Address *, Address *);
 	void logNodeRemove(Address *, Address *);
+	void setStaging(bool on);
+	void flushStaged(Address *addr);
+	void flush();
+	void startWorker(int worker);
+	void finishWorker();
+	void mergeWorkers(int workers);
 };
 
 #endif /* _LOG_H_ */
@@ -0,0 +1,268 @@
+/**********************************
+ * FILE NAME: LogWriter.cpp
+ *
+ * DESCRIPTION: Definition of LogWriter class
+ **********************************/
+
+#include "LogWriter.h"
+
+LogWriter *LogWriter::instance = nullptr;
+
+/**
+ * Constructor
+ *
+ * Opens both log files and starts the background thread.
+ */
+LogWriter::LogWriter(const char *dbgFile, const char *statsFile): tail(0), head(0), flushed(0), stopping(false) {
+	files[LOG_DBG] = fopen(dbgFile, "w");
+	files[LOG_STATS] = fopen(statsFile, "w");
+	batchLen[LOG_DBG] = 0;
+	batchLen[LOG_STATS] = 0;
+	ring = new log_record[LOG_RING_SIZE];
+	for ( unsigned long i = 0; i < LOG_RING_SIZE; i++ ) {
+		ring[i].seq.store(i, memory_order_relaxed);
+	}
+	worker = thread(&LogWriter::run, this);
+}
+
+/**
+ * Destructor
+ */
+LogWriter::~LogWriter() {
+	shutdown();
+	delete[] ring;
+}
+
+/**
+ * FUNCTION NAME: getInstance
+ *
+ * DESCRIPTION: Return the process-wide writer, opening the log files on first use
+ */
+LogWriter *LogWriter::getInstance(const char *dbgFile, const char *statsFile) {
+	if ( instance == nullptr ) {
+		instance = new LogWriter(dbgFile, statsFile);
+		atexit(shutdownAtExit);
+	}
+	return instance;
+}
+
+/**
+ * FUNCTION NAME: reopen
+ *
+ * DESCRIPTION: Start a fresh writer on other files in a forked child. The
+ * 				inherited writer has no thread behind it in the child, so it is
+ * 				abandoned as is; flush it in the parent before forking.
+ */
+LogWriter *LogWriter::reopen(const char *dbgFile, const char *statsFile) {
+	instance = new LogWriter(dbgFile, statsFile);
+	return instance;
+}
+
+/**
+ * FUNCTION NAME: shutdownAtExit
+ *
+ * DESCRIPTION: atexit hook making sure every pending line reaches the files
+ */
+void LogWriter::shutdownAtExit() {
+	if ( instance != nullptr ) {
+		instance->shutdown();
+	}
+}
+
+/**
+ * FUNCTION NAME: claim
+ *
+ * DESCRIPTION: Reserve the next count free slots of the ring, waiting while the ring
+ * 				is full, and return the position of the first. The slots are consecutive,
+ * 				so the records of a long line are not interleaved with other lines.
+ * 				Each slot's sequence number equals its position when free, position + 1
+ * 				once published, and position + LOG_RING_SIZE once consumed.
+ */
+unsigned long LogWriter::claim(int count) {
+	unsigned long p = tail.load(memory_order_relaxed);
+	while ( true ) {
+		// slots are consumed in order, so if the last one is free all of them are
+		unsigned long last = p + count - 1;
+		log_record *rec = &ring[last & (LOG_RING_SIZE - 1)];
+		long dif = (long)rec->seq.load(memory_order_acquire) - (long)last;
+		if ( dif == 0 ) {
+			if ( tail.compare_exchange_weak(p, p + count, memory_order_relaxed) ) {
+				return p;
+			}
+		}
+		else if ( dif < 0 ) {
+			// ring is full, let the writer catch up
+			this_thread::yield();
+			p = tail.load(memory_order_relaxed);
+		}
+		else {
+			p = tail.load(memory_order_relaxed);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: publish
+ *
+ * DESCRIPTION: Hand a filled slot over to the background thread
+ */
+void LogWriter::publish(log_record *rec, unsigned long pos) {
+	rec->seq.store(pos + 1, memory_order_release);
+}
+
+/**
+ * FUNCTION NAME: put
+ *
+ * DESCRIPTION: Queue text in as many consecutive records as it takes. Only the first
+ * 				record carries the prefix, if any; the others continue the text.
+ */
+void LogWriter::put(int file, Address *addr, int time, bool prefixed, const char *text) {
+	int len = strlen(text);
+	int count = max(1, (len + LOG_BODY_SIZE - 2) / (LOG_BODY_SIZE - 1));
+	unsigned long pos = claim(count);
+	for ( int i = 0; i < count; i++ ) {
+		log_record *rec = &ring[(pos + i) & (LOG_RING_SIZE - 1)];
+		int off = i * (LOG_BODY_SIZE - 1);
+		int n = min(len - off, LOG_BODY_SIZE - 1);
+		rec->file = file;
+		rec->prefixed = prefixed && i == 0;
+		rec->hasAddr = (addr != nullptr);
+		if ( addr != nullptr ) {
+			rec->addr = *addr;
+		}
+		rec->time = time;
+		memcpy(rec->body, text + off, n);
+		rec->body[n] = 0;
+		publish(rec, pos + i);
+	}
+}
+
+/**
+ * FUNCTION NAME: append
+ *
+ * DESCRIPTION: Queue one log line. The line is written as "\n <addr> [<time>] <body>";
+ * 				a null addr leaves the address empty.
+ */
+void LogWriter::append(int file, Address *addr, int time, const char *body) {
+	put(file, addr, time, true, body);
+}
+
+/**
+ * FUNCTION NAME: appendRaw
+ *
+ * DESCRIPTION: Queue text to be written verbatim
+ */
+void LogWriter::appendRaw(int file, const char *text) {
+	put(file, nullptr, 0, false, text);
+}
+
+/**
+ * FUNCTION NAME: drain
+ *
+ * DESCRIPTION: Format every published record into the batches.
+ * 				Returns false if there was nothing to consume.
+ */
+bool LogWriter::drain() {
+	bool any = false;
+	while ( true ) {
+		log_record *rec = &ring[head & (LOG_RING_SIZE - 1)];
+		if ( rec->seq.load(memory_order_acquire) != head + 1 ) {
+			break;
+		}
+		format(rec);
+		rec->seq.store(head + LOG_RING_SIZE, memory_order_release);
+		head++;
+		any = true;
+	}
+	return any;
+}
+
+/**
+ * FUNCTION NAME: format
+ *
+ * DESCRIPTION: Append the text of one record to the batch of its file
+ */
+void LogWriter::format(log_record *rec) {
+	char stdstring[30];
+	int file = rec->file;
+	// address (30) + time (16) + body, with room to spare
+	if ( batchLen[file] + LOG_BODY_SIZE + 64 > LOG_BATCH_SIZE ) {
+		writeBatch(file);
+	}
+	char *out = batch[file] + batchLen[file];
+	if ( !rec->prefixed ) {
+		batchLen[file] += sprintf(out, "%s", rec->body);
+		return;
+	}
+	stdstring[0] = 0;
+	if ( rec->hasAddr ) {
+		Address *addr = &rec->addr;
+		sprintf(stdstring, "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], addr->getPort());
+	}
+	batchLen[file] += sprintf(out, "\n %s[%d] %s", stdstring, rec->time, rec->body);
+}
+
+/**
+ * FUNCTION NAME: writeBatch
+ *
+ * DESCRIPTION: Hand the formatted batch of a file to stdio
+ */
+void LogWriter::writeBatch(int file) {
+	if ( batchLen[file] > 0 ) {
+		fwrite(batch[file], 1, batchLen[file], files[file]);
+		batchLen[file] = 0;
+	}
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Background thread. Consumes records until shutdown is requested
+ * 				and the ring is empty, writing and flushing whenever it runs dry.
+ */
+void LogWriter::run() {
+	while ( true ) {
+		bool stop = stopping.load(memory_order_acquire);
+		if ( drain() ) {
+			continue;
+		}
+		if ( flushed.load(memory_order_relaxed) != head ) {
+			writeBatch(LOG_DBG);
+			writeBatch(LOG_STATS);
+			fflush(files[LOG_DBG]);
+			fflush(files[LOG_STATS]);
+			flushed.store(head, memory_order_release);
+		}
+		if ( stop ) {
+			break;
+		}
+		this_thread::sleep_for(chrono::microseconds(200));
+	}
+}
+
+/**
+ * FUNCTION NAME: flush
+ *
+ * DESCRIPTION: Block until every line queued so far is written and flushed
+ */
+void LogWriter::flush() {
+	unsigned long target = tail.load(memory_order_acquire);
+	while ( flushed.load(memory_order_acquire) < target ) {
+		this_thread::yield();
+	}
+}
+
+/**
+ * FUNCTION NAME: shutdown
+ *
+ * DESCRIPTION: Write out everything pending, stop the thread and close the files
+ */
+void LogWriter::shutdown() {
+	if ( !worker.joinable() ) {
+		return;
+	}
+	stopping.store(true, memory_order_release);
+	worker.join();
+	fclose(files[LOG_DBG]);
+	fclose(files[LOG_STATS]);
+}
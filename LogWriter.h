@@ -0,0 +1,93 @@
+/**********************************
+ * FILE NAME: LogWriter.h
+ *
+ * DESCRIPTION: Header file of LogWriter class
+ **********************************/
+
+#ifndef _LOGWRITER_H_
+#define _LOGWRITER_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+
+/*
+ * Macros
+ */
+// number of records the ring holds, must be a power of two
+#define LOG_RING_SIZE 8192
+// text held per record, terminator included; a longer line takes
+// consecutive records
+#define LOG_BODY_SIZE 240
+// bytes formatted before they are handed to fwrite
+#define LOG_BATCH_SIZE (64 * 1024)
+// log files
+#define LOG_DBG 0
+#define LOG_STATS 1
+
+/**
+ * STRUCT NAME: log_record
+ *
+ * DESCRIPTION: One fixed-size slot of the log ring
+ */
+typedef struct log_record {
+	// ring sequence number, see LogWriter::push
+	atomic<unsigned long> seq;
+	// LOG_DBG or LOG_STATS
+	int file;
+	// false for records written verbatim, without address and time prefix,
+	// as are the records continuing a long line
+	bool prefixed;
+	// false if the address prefix is left empty
+	bool hasAddr;
+	Address addr;
+	int time;
+	char body[LOG_BODY_SIZE];
+}log_record;
+
+/**
+ * CLASS NAME: LogWriter
+ *
+ * DESCRIPTION: Asynchronous writer behind Log::LOG.
+ * 				Callers push fixed-size records into a lock-free bounded ring
+ * 				(multi-producer, single-consumer); a line longer than one record
+ * 				takes consecutive ones. A background thread formats
+ * 				the records into the dbg.log line format and writes them in
+ * 				large batches, flushing only when the ring runs dry. When the
+ * 				ring is full callers wait, so no line is ever dropped. Every
+ * 				pending record is written and the files closed at exit.
+ */
+class LogWriter {
+private:
+	FILE *files[2];
+	log_record *ring;
+	atomic<unsigned long> tail;
+	unsigned long head;
+	// records written out and flushed
+	atomic<unsigned long> flushed;
+	atomic<bool> stopping;
+	thread worker;
+	char batch[2][LOG_BATCH_SIZE];
+	int batchLen[2];
+	static LogWriter *instance;
+	LogWriter(const char *dbgFile, const char *statsFile);
+	LogWriter(const LogWriter &anotherWriter);
+	LogWriter& operator =(const LogWriter &anotherWriter);
+	unsigned long claim(int count);
+	void publish(log_record *rec, unsigned long pos);
+	void put(int file, Address *addr, int time, bool prefixed, const char *text);
+	bool drain();
+	void format(log_record *rec);
+	void writeBatch(int file);
+	void run();
+	static void shutdownAtExit();
+public:
+	static LogWriter *getInstance(const char *dbgFile, const char *statsFile);
+	static LogWriter *reopen(const char *dbgFile, const char *statsFile);
+	void append(int file, Address *addr, int time, const char *body);
+	void appendRaw(int file, const char *text);
+	void flush();
+	void shutdown();
+	virtual ~LogWriter();
+};
+
+#endif /* _LOGWRITER_H_ */
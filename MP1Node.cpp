@@ -16,7 +16,7 @@
  * You can add new members to the class if you think it
  * is necessary for your logic to work
  */
-MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Address *address) {
+MP1Node::MP1Node(Member *member, Params *params, Transport *emul, Log *log, Address *address) {
 	for( int i = 0; i < 6; i++ ) {
 		NULLADDR[i] = 0;
 	}
@@ -25,6 +25,15 @@ MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Addres
 	this->log = log;
 	this->par = params;
 	this->memberNode->addr = *address;
+	this->lastGossip = -1;
+	this->gossipRounds = 0;
+	this->pingNext = 0;
+	this->probeNext = 0;
+	this->probeStart = -1;
+	this->probeAcked = true;
+	this->probeIndirect = false;
+	this->rng.seed(rand());
+	this->sendBuf.resize(maxPayloadSize());
 }
 
 /**
@@ -96,9 +105,6 @@ int MP1Node::initThisNode(Address *joinaddr) {
 	/*
 	 * This function is partially implemented and may require changes
 	 */
-	int id = *(int*)(&memberNode->addr.addr);
-	int port = *(short*)(&memberNode->addr.addr[4]);
-
 	memberNode->bFailed = false;
 	memberNode->inited = true;
 	memberNode->inGroup = false;
@@ -118,9 +124,9 @@ int MP1Node::initThisNode(Address *joinaddr) {
  * DESCRIPTION: Join the distributed system
  */
 int MP1Node::introduceSelfToGroup(Address *joinaddr) {
-	MessageHdr msg;
+	char msg[MSG_HDR_SIZE];
 #ifdef DEBUGLOG
-    static char s[1024];
+    char s[1024];
 #endif
 
     if ( 0 == memcmp((char *)&(memberNode->addr.addr), (char *)&(joinaddr->addr), sizeof(memberNode->addr.addr))) {
@@ -133,9 +139,7 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
     else {
         
         // Create JOINREQ message
-        msg.msgType = JOINREQ;
-        msg.memberList = memberNode->memberList;
-        msg.addr = &memberNode->addr;
+        MessageWriter writer(msg, sizeof(msg), JOINREQ, &memberNode->addr, memberNode->heartbeat, memberNode->incarnation);
 
 #ifdef DEBUGLOG
         sprintf(s, "Trying to join...");
@@ -143,7 +147,7 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 #endif
 
         // send JOINREQ message to introducer member
-        emulNet->ENsend(&memberNode->addr, joinaddr, (char *)&msg, sizeof(msg));
+        emulNet->ENsend(&memberNode->addr, joinaddr, msg, writer.getSize());
 
     }
 
@@ -179,12 +183,15 @@ void MP1Node::nodeLoop() {
     checkMessages();
 
     // Wait until you're in the group...
-    if( !memberNode->inGroup ) {
-    	return;
+    // ...then jump in and share your responsibilites!
+    if( memberNode->inGroup ) {
+    	nodeLoopOps();
     }
 
-    // ...then jump in and share your responsibilites!
-    nodeLoopOps();
+    // Messages coalesced during this step leave together
+    if( par->COALESCE ) {
+    	outbox.flush(emulNet, &memberNode->addr);
+    }
 
     return;
 }
@@ -193,6 +200,7 @@ void MP1Node::nodeLoop() {
  * FUNCTION NAME: checkMessages
  *
  * DESCRIPTION: Check messages in the queue and call the respective message handler
+ * 				The messages of a BATCH are handled in order before its buffer is released.
  */
 void MP1Node::checkMessages() {
     void *ptr;
@@ -203,7 +211,17 @@ void MP1Node::checkMessages() {
     	ptr = memberNode->mp1q.front().elt;
     	size = memberNode->mp1q.front().size;
     	memberNode->mp1q.pop();
-    	recvCallBack((void *)memberNode, (char *)ptr, size);
+    	if ( Coalescer::unpack((char *)ptr, size, batched) ) {
+    	    // a BATCH: each message it carries is handled on its own
+    	    for ( pair<char *, int> &m : batched ) {
+    	        recvCallBack((void *)memberNode, m.first, m.second);
+    	    }
+    	}
+    	else {
+    	    recvCallBack((void *)memberNode, (char *)ptr, size);
+    	}
+    	// hand the network buffer back once the handler is done with it
+    	emulNet->ENrelease((char *)ptr);
     }
     return;
 }
@@ -214,92 +232,156 @@ void MP1Node::checkMessages() {
  * DESCRIPTION: Message handler for different message types
  */
 bool MP1Node::recvCallBack(void *env, char *data, int size ) {
-	MessageHdr* msg = (MessageHdr*) data;
-    switch (msg->msgType)
+    MessageView msg(data, size);
+    if ( !msg.isValid() ) {
+        return false;
+    }
+    switch (msg.getType())
     {
     case JOINREQ: {
-        updateMemberList(msg);
-        Address* to = msg->addr;
-        sendMessage(to, JOINREP); 
+        Address to = msg.getSender();
+        if (par->SWIM)
+            addMember(&to, msg.getHeartbeat(), msg.getIncarnation(), true);
+        else
+            updateMemberList(&msg);
+        sendMessage(&to, JOINREP); 
     }
     break;
     case JOINREP: {
-        updateMemberList(msg); 
+        if (par->SWIM) {
+            Address from = msg.getSender();
+            addMember(&from, msg.getHeartbeat(), msg.getIncarnation(), false);
+            applyEvents(&msg, false);
+        } else {
+            updateMemberList(&msg); 
+        }
         memberNode->inGroup = true;
     }
     break;
     case PING: {
-        handlePing(msg);
+        if (par->SWIM)
+            handleSwimMessage(&msg);
+        else
+            handlePing(&msg);
+    }
+    break;
+    case ACK:
+    case PINGREQ: {
+        if (par->SWIM)
+            handleSwimMessage(&msg);
     }
     break;
     default:
         break;
     }
-    free(msg);
     return true;
 }
 /**
  * FUNCTION NAME: updateMemberList  
  * 
  * DESCRIPTION: If a node does not exist in the memberList, it will be pushed to the memberList.
+ * 				A removed node comes back only with a newer heartbeat or incarnation.
  */
-void MP1Node::updateMemberList(MessageHdr* msg) {
+void MP1Node::updateMemberList(MessageView* msg) {
     // id, port, heartbeat, timestamp
-    int id = 0;
-	short port;
-	memcpy(&id, &msg->addr->addr[0], sizeof(int));
-	memcpy(&port, &msg->addr->addr[4], sizeof(short));
-    long heartbeat = 1;
+    Address sender = msg->getSender();
+    long heartbeat = msg->getHeartbeat();
     long timestamp =  this->par->getcurrtime();
-    if(getMemberIfPresent(id, port) != nullptr)
+    if(getMemberIfPresent(sender.getId(), sender.getPort()) != nullptr)
+        return;
+    MemberListEntry e(sender.getId(), sender.getPort(), heartbeat, timestamp);
+    e.incarnation = msg->getIncarnation();
+    if(isStale(&e))
         return;
-    MemberListEntry e(id, port, heartbeat, timestamp);
-    memberNode->memberList.push_back(e);
-    Address* added = createAddress(id,port);
-    log->logNodeAdd(&memberNode->addr ,added);
-    free(added);
+    tombstones.erase(sender.getKey());
+    armTimer(memberNode->memberList.insert(e));
+    log->logNodeAdd(&memberNode->addr, &sender);
+    queueEvent(&e);
 }
 
 void MP1Node::updateMemberList(MemberListEntry* e) {
-    Address* addr = createAddress(e->id, e->port);
+    Address addr(e->id, e->port);
     
-    if (*addr == memberNode->addr) {
-        free(addr);
+    if (addr == memberNode->addr) {
         return;
     }
 
-    if (par->getcurrtime() - e->timestamp < TREMOVE) {
-        log->logNodeAdd(&memberNode->addr, addr);
+    // suspected members are not added, nor removed ones from stale gossip
+    if (e->state != MEMBER_ALIVE || isStale(e)) {
+        return;
+    }
+
+    if (par->getcurrtime() - e->timestamp < TREMOVE * par->GOSSIP_INTERVAL) {
+        log->logNodeAdd(&memberNode->addr, &addr);
         MemberListEntry new_entry = *e;
-        memberNode->memberList.push_back(new_entry);
+        new_entry.setlastchanged(par->getcurrtime());
+        tombstones.erase(addr.getKey());
+        armTimer(memberNode->memberList.insert(new_entry));
+        queueEvent(&new_entry);
     }
-    delete addr;
 }
+
 /**
- * FUNCTION NAME: createAddress
+ * FUNCTION NAME: getMemberIfPresent 
  * 
- * DESCRIPTION: create new address
+ * DESCRIPTION: Return if a node is present in the member list 
  */
-Address* MP1Node::createAddress(int id, short port) {
-    string ad = to_string(id) + ":" + to_string(port);
-    Address* address = new Address(ad);
-    return address;
+MemberListEntry* MP1Node::getMemberIfPresent(int id, short port) {
+    return memberNode->memberList.find(id, port);
 }
 
+
 /**
- * FUNCTION NAME: getMemberIfPresent 
+ * FUNCTION NAME: maxPayloadSize
  * 
- * DESCRIPTION: Return if a node is present in the member list 
+ * DESCRIPTION: Largest message the transport accepts
  */
-MemberListEntry* MP1Node::getMemberIfPresent(int id, short port) {
-    int j =0;
-    for (auto i = memberNode->memberList.begin(); i < memberNode->memberList.end(); i++, j++){
-        if(i->getid() == id && i->getport() == port)
-            return &memberNode->memberList[j];
-    } 
-    return nullptr;
+int MP1Node::maxPayloadSize() {
+    return emulNet->ENmaxPayload();
+}
+
+/**
+ * FUNCTION NAME: encodeMessage 
+ * 
+ * DESCRIPTION: Encode a message of type t carrying as much of the membership list
+ * 				as fits in capacity bytes. Returns the encoded size.
+ * 				If since is not negative only entries changed after that time are carried.
+ * 				A PING that cannot carry the whole list starts where the previous PING
+ * 				stopped, so every member is carried over successive PINGs. Other
+ * 				messages carry the list from its start.
+ */
+int MP1Node::encodeMessage(MsgTypes t, char *buf, int capacity, long since) {
+    MessageWriter writer(buf, capacity, t, &memberNode->addr, memberNode->heartbeat, memberNode->incarnation);
+    int n = memberNode->memberList.size();
+    int start = (t == PING && pingNext < n) ? pingNext : 0;
+    int stop = 0;
+    for (int k = 0; k < n; k++) {
+        int i = (start + k) % n;
+        MemberListEntry &e = memberNode->memberList[i];
+        if (since >= 0 && e.getlastchanged() <= since)
+            continue;
+        if (!writer.append(&e)) {
+            stop = i;
+            break;
+        }
+    }
+    if (t == PING)
+        pingNext = stop;
+    return writer.getSize();
 }
 
+/**
+ * FUNCTION NAME: send
+ *
+ * DESCRIPTION: Send an encoded message, or with COALESCE hold it with the others
+ * 				for the same destination until the end of the step
+ */
+void MP1Node::send(Address *to, char *data, int size) {
+    if (par->COALESCE)
+        outbox.add(emulNet, &memberNode->addr, to, data, size);
+    else
+        emulNet->ENsend(&memberNode->addr, to, data, size);
+}
 
 /**
  * FUNCTION NAME: sendMessage 
@@ -307,38 +389,79 @@ MemberListEntry* MP1Node::getMemberIfPresent(int id, short port) {
  * DESCRIPTION: send message 
  */
 void MP1Node::sendMessage(Address* to, MsgTypes t) {
-    MessageHdr* msg = new MessageHdr();
-    msg->msgType = t;
-    msg->memberList = memberNode->memberList;
-    msg->addr = &memberNode->addr;
-    emulNet->ENsend(&memberNode->addr, to, (char*)msg, sizeof(*msg));    
+    int size = encodeMessage(t, &sendBuf[0], sendBuf.size());
+    send(to, &sendBuf[0], size);
 }
 
 /**
  * FUNCTION NAME: handlePing 
  * 
  * DESCRIPTION: The function handles the ping messages. 
+ * 				Changes of state are queued for piggybacking; fresher heartbeats are not.
+ * 				A fresher heartbeat marks the entry changed for delta gossip only
+ * 				with GOSSIP_FANOUT: otherwise every member PINGs every other and
+ * 				hears heartbeats first hand, so deltas carry only changes of state.
  */
-void MP1Node::handlePing(MessageHdr* msg) {
-    size_t pos = msg->addr->getAddress().find(":");
-	int id = stoi(msg->addr->getAddress().substr(0, pos));
-	short port = (short)stoi(msg->addr->getAddress().substr(pos + 1, msg->addr->getAddress().size()-pos-1));
+void MP1Node::handlePing(MessageView* msg) {
+    Address sender = msg->getSender();
     
-    MemberListEntry* pingFrom = getMemberIfPresent(id, port);
+    MemberListEntry* pingFrom = getMemberIfPresent(sender.getId(), sender.getPort());
     if(pingFrom != nullptr){
-        pingFrom->heartbeat++;
+        // Direct contact proves liveness even if the heartbeat is not newer
+        if(msg->getHeartbeat() > pingFrom->heartbeat)
+            pingFrom->heartbeat = msg->getHeartbeat();
+        bool changed = msg->getIncarnation() > pingFrom->incarnation || pingFrom->state != MEMBER_ALIVE;
+        if(msg->getIncarnation() > pingFrom->incarnation)
+            pingFrom->incarnation = msg->getIncarnation();
+        pingFrom->state = MEMBER_ALIVE;
         pingFrom->settimestamp(par->getcurrtime());
+        if(changed || par->GOSSIP_FANOUT > 0)
+            pingFrom->setlastchanged(par->getcurrtime());
+        armTimer(pingFrom);
+        if(changed)
+            queueEvent(pingFrom);
     }else{
         updateMemberList(msg);
     }
 
-    for(auto i : msg->memberList){
+    for(int k = 0; k < msg->getNumEntries(); k++){
+        MemberListEntry i = msg->getEntry(k);
+        if(i.getid() == memberNode->addr.getId() && i.getport() == memberNode->addr.getPort()){
+            // a suspicion about this node is refuted on the next PING
+            refute(&i);
+            continue;
+        }
         MemberListEntry* node = getMemberIfPresent(i.getid(), i.getport());  
-        // If a member is already present update if it has latest heartbeat
+        // If a member is already present update if it has a later incarnation or heartbeat
         if(node != nullptr){
-            if(i.getheartbeat() > node->heartbeat){
-                node->heartbeat = i.getheartbeat();
+            bool newer = i.incarnation > node->incarnation || (i.incarnation == node->incarnation && i.getheartbeat() > node->heartbeat);
+            if(i.state == MEMBER_FAILED){
+                // a removal made without fresher news than ours
+                if(!newer && (i.incarnation < node->incarnation || i.getheartbeat() < node->heartbeat))
+                    continue;
+                Address toRemove(i.getid(), i.getport());
+                log->logNodeRemove(&memberNode->addr, &toRemove);
+                bury(&i);
+                timers.cancel(memberNode->memberList.slotOf(node));
+                memberNode->memberList.erase(i.getid(), i.getport());
+                queueEvent(&i);
+            } else if(newer){
+                bool changed = i.incarnation > node->incarnation || i.state != node->state;
+                node->heartbeat = max(node->heartbeat, i.getheartbeat());
+                node->incarnation = i.incarnation;
+                node->state = i.state;
                 node->timestamp = par->getcurrtime();
+                if(changed || par->GOSSIP_FANOUT > 0)
+                    node->lastchanged = par->getcurrtime();
+                armTimer(node);
+                if(changed)
+                    queueEvent(node);
+            } else if(i.incarnation == node->incarnation && i.getheartbeat() == node->heartbeat && i.state == MEMBER_SUSPECT && node->state == MEMBER_ALIVE){
+                // same news, but the sender has waited longer for the next heartbeat
+                node->state = MEMBER_SUSPECT;
+                node->lastchanged = par->getcurrtime();
+                armTimer(node);
+                queueEvent(node);
             }
         } else {
             // update the list
@@ -356,27 +479,572 @@ void MP1Node::handlePing(MessageHdr* msg) {
  */
 void MP1Node::nodeLoopOps() {
 
+    if (par->SWIM) {
+        swimLoopOps();
+        return;
+    }
+
+    // suspect members silent for TFAIL rounds and delete those silent for TREMOVE
+    expireTimers();
+
+    // Gossip once every GOSSIP_INTERVAL
+    if (lastGossip >= 0 && par->getcurrtime() - lastGossip < par->GOSSIP_INTERVAL)
+        return;
     memberNode->heartbeat++;
+    pruneTombstones(2 * TREMOVE * par->GOSSIP_INTERVAL);
 
-    // delete members
-    for (auto i = memberNode->memberList.begin(); i < memberNode->memberList.end(); i++) {
-        if(par->getcurrtime() - i->gettimestamp() >= TREMOVE) {
-            Address* toRemove = createAddress(i->getid(), i->getport());
-            log->logNodeRemove(&memberNode->addr, toRemove);
-            memberNode->memberList.erase(i--);
-            delete toRemove;
-        }
+    // In delta mode carry only the entries changed since the previous round,
+    // with a full sync every FULL_SYNC_INTERVAL rounds
+    long since = -1;
+    if (par->DELTA_GOSSIP && lastGossip >= 0) {
+        if (par->FULL_SYNC_INTERVAL <= 0 || gossipRounds % par->FULL_SYNC_INTERVAL != 0)
+            since = lastGossip;
     }
+    lastGossip = par->getcurrtime();
+    gossipRounds++;
 
-    // send PING to the members of memberList
-    for (auto node : memberNode->memberList) {
-        Address* address = createAddress(node.getid(), node.getport());
-        sendMessage(address, PING);
-        free(address);
+    // send PING to GOSSIP_FANOUT random members, or to all of memberList,
+    // encoding the list (or with PIGGYBACK, the pending events) only once
+    // and handing all targets over in one batch
+    char *msg = &sendBuf[0];
+    int size;
+    if (par->PIGGYBACK) {
+        MessageWriter writer(msg, sendBuf.size(), PING, &memberNode->addr, memberNode->heartbeat, memberNode->incarnation);
+        piggyback(&writer);
+        size = writer.getSize();
+    } else {
+        size = encodeMessage(PING, msg, sendBuf.size(), since);
+    }
+    gossipAddrs.clear();
+    if (par->GOSSIP_FANOUT > 0 && par->GOSSIP_FANOUT < (int)memberNode->memberList.size()) {
+        pickGossipTargets(par->GOSSIP_FANOUT);
+        for (int idx : gossipTargets) {
+            MemberListEntry &node = memberNode->memberList[idx];
+            gossipAddrs.push_back(Address(node.getid(), node.getport()));
+        }
+    } else {
+        for (int i = 0; i < memberNode->memberList.size(); i++) {
+            MemberListEntry &node = memberNode->memberList[i];
+            gossipAddrs.push_back(Address(node.getid(), node.getport()));
+        }
+    }
+    // with COALESCE the PING joins messages already waiting for a target;
+    // the other targets still share one copy of it through ENsendBatch
+    if (par->COALESCE) {
+        int kept = 0;
+        for (Address &to : gossipAddrs) {
+            if (outbox.has(&to))
+                outbox.add(emulNet, &memberNode->addr, &to, msg, size);
+            else
+                gossipAddrs[kept++] = to;
+        }
+        gossipAddrs.resize(kept);
     }
+    if (!gossipAddrs.empty())
+        emulNet->ENsendBatch(&memberNode->addr, &gossipAddrs[0], gossipAddrs.size(), msg, size);
     return;
 }
 
+/**
+ * FUNCTION NAME: nextWakeup
+ *
+ * DESCRIPTION: Earliest time nodeLoopOps has work to do: the next gossip round
+ * 				or failure detection deadline, or in SWIM mode the next step of
+ * 				the probe, suspicion deadline or relay expiry. Messages wake the
+ * 				node on their own. Used by the event engine to skip idle nodes.
+ *
+ * RETURNS:
+ * a time after the current time, or -1 if only a message can give the node work
+ */
+long MP1Node::nextWakeup() {
+    if (memberNode->bFailed || !memberNode->inGroup)
+        return -1;
+    long now = par->getcurrtime();
+    long next = -1;
+    auto earliest = [&next](long t) { next = (next < 0) ? t : min(next, t); };
+    if (par->SWIM) {
+        // the next probe is due once the period is over, if there is anyone to probe
+        if (probeStart >= 0 && now - probeStart < par->SWIM_PERIOD)
+            earliest(probeStart + par->SWIM_PERIOD);
+        else if (!memberNode->memberList.empty())
+            earliest(now + 1);
+        if (probeStart >= 0 && !probeAcked && !probeIndirect)
+            earliest(probeStart + par->SWIM_ACK_TIMEOUT);
+        for (Address &a : suspects) {
+            MemberListEntry *e = getMemberIfPresent(a.getId(), a.getPort());
+            if (e != nullptr && e->state == MEMBER_SUSPECT)
+                earliest(e->getlastchanged() + suspectTimeout());
+        }
+        for (swim_relay &r : relays)
+            earliest(r.since + par->SWIM_PERIOD);
+    } else {
+        earliest((lastGossip < 0) ? now + 1 : lastGossip + par->GOSSIP_INTERVAL);
+        long due = timers.nextDue();
+        if (due >= 0)
+            earliest(due);
+    }
+    if (next < 0)
+        return -1;
+    return max(next, now + 1);
+}
+
+/**
+ * FUNCTION NAME: armTimer
+ *
+ * DESCRIPTION: Gossip mode: set the failure detection deadline of a member from
+ * 				its timestamp, TFAIL rounds ahead while it is alive and TREMOVE
+ * 				rounds ahead once it is suspected
+ */
+void MP1Node::armTimer(MemberListEntry *e) {
+    long rounds = (e->state == MEMBER_ALIVE) ? TFAIL : TREMOVE;
+    timers.schedule(memberNode->memberList.slotOf(e), e->timestamp + rounds * par->GOSSIP_INTERVAL);
+}
+
+/**
+ * FUNCTION NAME: expireTimers
+ *
+ * DESCRIPTION: Gossip mode: suspect the members silent for TFAIL rounds and
+ * 				delete those silent for TREMOVE, looking only at the members whose
+ * 				deadline has come rather than at the whole list
+ */
+void MP1Node::expireTimers() {
+    expiredSlots.clear();
+    timers.advance(par->getcurrtime(), expiredSlots);
+    for (int slot : expiredSlots) {
+        MemberListEntry *e = memberNode->memberList.atSlot(slot);
+        if (e == nullptr)
+            continue;
+        Address addr(e->getid(), e->getport());
+        if (par->getcurrtime() - e->gettimestamp() >= TREMOVE * par->GOSSIP_INTERVAL) {
+            log->logNodeRemove(&memberNode->addr, &addr);
+            bury(e);
+            MemberListEntry removed = *e;
+            removed.state = MEMBER_FAILED;
+            memberNode->memberList.erase(e->getid(), e->getport());
+            queueEvent(&removed);
+            continue;
+        }
+        if (e->state == MEMBER_ALIVE && par->getcurrtime() - e->gettimestamp() >= TFAIL * par->GOSSIP_INTERVAL) {
+            e->state = MEMBER_SUSPECT;
+            e->setlastchanged(par->getcurrtime());
+            queueEvent(e);
+        }
+        armTimer(e);
+    }
+}
+
+/**
+ * FUNCTION NAME: pickGossipTargets
+ *
+ * DESCRIPTION: Choose up to k distinct random members that have been heard from
+ * 				within TFAIL rounds. The picked indices are left in gossipTargets.
+ */
+void MP1Node::pickGossipTargets(int k) {
+    int n = memberNode->memberList.size();
+    gossipTargets.clear();
+    for (int attempts = 0; (int)gossipTargets.size() < k && attempts < 4 * k; attempts++) {
+        int idx = rng() % n;
+        if (par->getcurrtime() - memberNode->memberList[idx].gettimestamp() >= TFAIL * par->GOSSIP_INTERVAL)
+            continue;
+        if (find(gossipTargets.begin(), gossipTargets.end(), idx) != gossipTargets.end())
+            continue;
+        gossipTargets.push_back(idx);
+    }
+}
+
+/**
+ * FUNCTION NAME: swimLoopOps
+ *
+ * DESCRIPTION: SWIM protocol period. Escalate or conclude the current probe,
+ * 				confirm expired suspicions, then once every SWIM_PERIOD PING the
+ * 				next member in probe order
+ */
+void MP1Node::swimLoopOps() {
+    long now = par->getcurrtime();
+
+    // PINGREQs are only served for one period
+    for (int i = relays.size() - 1; i >= 0; i--) {
+        if (now - relays[i].since >= par->SWIM_PERIOD) {
+            relays[i] = relays.back();
+            relays.pop_back();
+        }
+    }
+
+    // suspects that have not refuted within suspectTimeout() are failed
+    long timeout = suspectTimeout();
+    for (int i = suspects.size() - 1; i >= 0; i--) {
+        MemberListEntry *e = getMemberIfPresent(suspects[i].getId(), suspects[i].getPort());
+        if (e != nullptr && e->state == MEMBER_SUSPECT && now - e->getlastchanged() < timeout)
+            continue;
+        if (e != nullptr && e->state == MEMBER_SUSPECT)
+            declareFailed(&suspects[i]);
+        suspects[i] = suspects.back();
+        suspects.pop_back();
+    }
+
+    if (probeStart >= 0 && !probeAcked) {
+        if (now - probeStart >= par->SWIM_PERIOD) {
+            // neither a direct nor a relayed ACK within the period
+            MemberListEntry *e = getMemberIfPresent(probeTarget.getId(), probeTarget.getPort());
+            if (e != nullptr && e->state == MEMBER_ALIVE)
+                suspect(e, e->incarnation);
+            probeAcked = true;
+        } else if (!probeIndirect && now - probeStart >= par->SWIM_ACK_TIMEOUT) {
+            // ask up to SWIM_INDIRECT other members to probe the target for us
+            probeIndirect = true;
+            int n = memberNode->memberList.size();
+            gossipTargets.clear();
+            for (int attempts = 0; n > 0 && (int)gossipTargets.size() < par->SWIM_INDIRECT && attempts < 4 * par->SWIM_INDIRECT; attempts++) {
+                int idx = rng() % n;
+                MemberListEntry &e = memberNode->memberList[idx];
+                if (Address(e.getid(), e.getport()) == probeTarget)
+                    continue;
+                if (find(gossipTargets.begin(), gossipTargets.end(), idx) != gossipTargets.end())
+                    continue;
+                gossipTargets.push_back(idx);
+            }
+            for (int idx : gossipTargets) {
+                MemberListEntry &e = memberNode->memberList[idx];
+                Address to(e.getid(), e.getport());
+                sendSwim(&to, PINGREQ, &probeTarget);
+            }
+        }
+    }
+
+    if (probeStart >= 0 && now - probeStart < par->SWIM_PERIOD)
+        return;
+
+    // by now every stale report of a removed member has died out
+    pruneTombstones(TREMOVE * par->SWIM_PERIOD);
+
+    if (!nextProbeTarget(&probeTarget))
+        return;
+    memberNode->heartbeat++;
+    probeStart = now;
+    probeAcked = false;
+    probeIndirect = false;
+    sendSwim(&probeTarget, PING, nullptr);
+}
+
+/**
+ * FUNCTION NAME: suspectTimeout
+ *
+ * DESCRIPTION: Time a suspected member has to refute the suspicion. Unless
+ * 				SWIM_SUSPECT_TIMEOUT is set, SWIM_SUSPECT_MULT * ceil(log2(N))
+ * 				protocol periods, N being the group size as known here, since a
+ * 				refutation takes about log2(N) periods to spread.
+ */
+long MP1Node::suspectTimeout() {
+    if (par->SWIM_SUSPECT_TIMEOUT > 0)
+        return par->SWIM_SUSPECT_TIMEOUT;
+    // the group is the listed members and this node
+    return (long)DisseminationBuffer::transmitLimit(par->SWIM_SUSPECT_MULT, memberNode->memberList.size() + 1) * par->SWIM_PERIOD;
+}
+
+/**
+ * FUNCTION NAME: nextProbeTarget
+ *
+ * DESCRIPTION: Next member to probe. Members are probed in a random order that
+ * 				is reshuffled once every member has been probed, so each is probed
+ * 				once per round. Returns false if the membership list is empty.
+ */
+bool MP1Node::nextProbeTarget(Address *target) {
+    while (true) {
+        if (probeNext >= (int)probeOrder.size()) {
+            probeOrder.clear();
+            for (int i = 0; i < memberNode->memberList.size(); i++) {
+                MemberListEntry &e = memberNode->memberList[i];
+                probeOrder.push_back(Address(e.getid(), e.getport()));
+            }
+            shuffle(probeOrder.begin(), probeOrder.end(), rng);
+            probeNext = 0;
+            if (probeOrder.empty())
+                return false;
+        }
+        Address next = probeOrder[probeNext++];
+        if (getMemberIfPresent(next.getId(), next.getPort()) != nullptr) {
+            *target = next;
+            return true;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: sendSwim
+ *
+ * DESCRIPTION: Send a SWIM message, piggybacking as many pending events as fit
+ */
+void MP1Node::sendSwim(Address *to, MsgTypes t, Address *target) {
+    MessageWriter writer(&sendBuf[0], sendBuf.size(), t, &memberNode->addr, memberNode->heartbeat, memberNode->incarnation, target);
+    piggyback(&writer);
+    send(to, &sendBuf[0], writer.getSize());
+}
+
+/**
+ * FUNCTION NAME: handleSwimMessage
+ *
+ * DESCRIPTION: Handle a PING, ACK or PINGREQ in SWIM mode. Hearing from a member
+ * 				proves it alive, and a higher incarnation in the header is passed on
+ * 				as a refutation; the piggybacked events are applied next. A sender
+ * 				removed at its current incarnation is not added back but is sent
+ * 				its failure again, so that it refutes it.
+ */
+void MP1Node::handleSwimMessage(MessageView *msg) {
+    Address sender = msg->getSender();
+    Address target = msg->getTarget();
+
+    MemberListEntry heard(sender.getId(), sender.getPort(), msg->getHeartbeat(), par->getcurrtime());
+    heard.incarnation = msg->getIncarnation();
+    MemberListEntry *from = getMemberIfPresent(sender.getId(), sender.getPort());
+    if (from != nullptr) {
+        from->settimestamp(par->getcurrtime());
+        // direct contact clears a local suspicion; only a refutation clears it elsewhere
+        from->state = MEMBER_ALIVE;
+        if (heard.incarnation > from->incarnation) {
+            // a refutation, passed on here since the piggybacked copy of it
+            // is no longer newer once the header has been applied
+            from->incarnation = heard.incarnation;
+            queueEvent(from);
+        }
+    } else if (isStale(&heard)) {
+        member_tombstone &t = tombstones[sender.getKey()];
+        heard.incarnation = t.incarnation;
+        heard.state = MEMBER_FAILED;
+        queueEvent(&heard);
+    } else {
+        addMember(&sender, heard.heartbeat, heard.incarnation, true);
+    }
+    applyEvents(msg, true);
+
+    switch (msg->getType()) {
+    case PING:
+        sendSwim(&sender, ACK, &memberNode->addr);
+        break;
+    case ACK:
+        if (!probeAcked && target == probeTarget)
+            probeAcked = true;
+        // a direct ACK may answer PINGREQs we are serving for the target
+        if (sender == target) {
+            for (int i = relays.size() - 1; i >= 0; i--) {
+                if (relays[i].target != target)
+                    continue;
+                Address origin = relays[i].origin;
+                relays[i] = relays.back();
+                relays.pop_back();
+                sendSwim(&origin, ACK, &target);
+            }
+        }
+        break;
+    case PINGREQ:
+        if (target == memberNode->addr) {
+            sendSwim(&sender, ACK, &memberNode->addr);
+        } else {
+            swim_relay relay = {target, sender, par->getcurrtime()};
+            relays.push_back(relay);
+            sendSwim(&target, PING, nullptr);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * FUNCTION NAME: applyEvents
+ *
+ * DESCRIPTION: Apply the membership events carried by a message, in SWIM order:
+ * 				alive overrides suspect only with a higher incarnation, suspect
+ * 				overrides alive at the same incarnation, failed overrides both.
+ * 				Events that change the membership list are passed on if spread
+ * 				is set; suspicions and failures always are.
+ */
+void MP1Node::applyEvents(MessageView *msg, bool spread) {
+    for (int k = 0; k < msg->getNumEntries(); k++) {
+        MemberListEntry e = msg->getEntry(k);
+        Address addr(e.getid(), e.getport());
+        if (addr == memberNode->addr) {
+            refute(&e);
+            continue;
+        }
+        MemberListEntry *node = getMemberIfPresent(e.getid(), e.getport());
+        if (node == nullptr) {
+            if (e.state == MEMBER_ALIVE && !isStale(&e))
+                addMember(&addr, e.getheartbeat(), e.incarnation, spread);
+            continue;
+        }
+        switch (e.state) {
+        case MEMBER_ALIVE:
+            if (e.incarnation > node->incarnation) {
+                node->incarnation = e.incarnation;
+                node->state = MEMBER_ALIVE;
+                node->settimestamp(par->getcurrtime());
+                if (spread)
+                    queueEvent(node);
+            }
+            break;
+        case MEMBER_SUSPECT:
+            if (e.incarnation > node->incarnation || (e.incarnation == node->incarnation && node->state == MEMBER_ALIVE))
+                suspect(node, e.incarnation);
+            break;
+        case MEMBER_FAILED:
+            if (e.incarnation >= node->incarnation)
+                declareFailed(&addr);
+            break;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: addMember
+ *
+ * DESCRIPTION: Return the entry of addr, adding it to the membership list and to
+ * 				the probe order if it is new. A new member's join is queued for
+ * 				dissemination if spread is set.
+ */
+MemberListEntry *MP1Node::addMember(Address *addr, long heartbeat, long incarnation, bool spread) {
+    MemberListEntry *e = getMemberIfPresent(addr->getId(), addr->getPort());
+    if (e != nullptr)
+        return e;
+    MemberListEntry entry(addr->getId(), addr->getPort(), heartbeat, par->getcurrtime());
+    entry.incarnation = incarnation;
+    entry.setlastchanged(par->getcurrtime());
+    e = memberNode->memberList.insert(entry);
+    tombstones.erase(addr->getKey());
+    log->logNodeAdd(&memberNode->addr, addr);
+    // new members are probed at a random point of the current round
+    int pos = probeNext + rng() % (probeOrder.size() - probeNext + 1);
+    probeOrder.insert(probeOrder.begin() + pos, *addr);
+    if (spread)
+        queueEvent(e);
+    return e;
+}
+
+/**
+ * FUNCTION NAME: suspect
+ *
+ * DESCRIPTION: Mark a member suspected at the given incarnation and queue the
+ * 				suspicion, which the member refutes if it is alive
+ */
+void MP1Node::suspect(MemberListEntry *e, long incarnation) {
+    e->incarnation = incarnation;
+    e->state = MEMBER_SUSPECT;
+    e->setlastchanged(par->getcurrtime());
+    suspects.push_back(Address(e->getid(), e->getport()));
+    queueEvent(e);
+}
+
+/**
+ * FUNCTION NAME: declareFailed
+ *
+ * DESCRIPTION: Remove a member and queue its failure for dissemination
+ */
+void MP1Node::declareFailed(Address *addr) {
+    MemberListEntry e = *getMemberIfPresent(addr->getId(), addr->getPort());
+    log->logNodeRemove(&memberNode->addr, addr);
+    memberNode->memberList.erase(addr->getId(), addr->getPort());
+    bury(&e);
+    e.state = MEMBER_FAILED;
+    queueEvent(&e);
+}
+
+/**
+ * FUNCTION NAME: queueEvent
+ *
+ * DESCRIPTION: Queue the current state of a member for piggybacking, replacing
+ * 				any pending event about the same member. Events are only kept
+ * 				in the modes that piggyback them.
+ */
+void MP1Node::queueEvent(MemberListEntry *e) {
+    if (par->SWIM || par->PIGGYBACK)
+        dissemination.push(e);
+}
+
+/**
+ * FUNCTION NAME: piggyback
+ *
+ * DESCRIPTION: Append pending events to an outgoing message. Each event is sent
+ * 				PIGGYBACK_LAMBDA * log2(N) times, N being the group size as known here.
+ *
+ * RETURNS:
+ * number of events appended
+ */
+int MP1Node::piggyback(MessageWriter *writer) {
+    // the group is the listed members and this node
+    int limit = DisseminationBuffer::transmitLimit(par->PIGGYBACK_LAMBDA, memberNode->memberList.size() + 1);
+    return dissemination.fill(writer, limit);
+}
+
+/**
+ * FUNCTION NAME: refute
+ *
+ * DESCRIPTION: Handle a report about this node. If it is suspected or declared
+ * 				failed at its current incarnation or later, move past that
+ * 				incarnation. The refutation rides on the next PING header and is
+ * 				queued as an event where events are piggybacked.
+ *
+ * RETURNS:
+ * true if the incarnation was raised
+ */
+bool MP1Node::refute(MemberListEntry *e) {
+    if (e->state == MEMBER_ALIVE || e->incarnation < memberNode->incarnation)
+        return false;
+    memberNode->incarnation = e->incarnation + 1;
+    MemberListEntry self(memberNode->addr.getId(), memberNode->addr.getPort(), memberNode->heartbeat, par->getcurrtime());
+    self.incarnation = memberNode->incarnation;
+    queueEvent(&self);
+    return true;
+}
+
+/**
+ * FUNCTION NAME: isStale
+ *
+ * DESCRIPTION: Return true if e is about a removed member and is not newer than
+ * 				what was known at the removal. In SWIM mode only a higher
+ * 				incarnation counts; in gossip mode a higher heartbeat does too.
+ */
+bool MP1Node::isStale(MemberListEntry *e) {
+    unordered_map<long, member_tombstone>::iterator it = tombstones.find(Address::makeKey(e->getid(), e->getport()));
+    if (it == tombstones.end())
+        return false;
+    member_tombstone &t = it->second;
+    if (e->incarnation != t.incarnation)
+        return e->incarnation < t.incarnation;
+    return par->SWIM || e->getheartbeat() <= t.heartbeat;
+}
+
+/**
+ * FUNCTION NAME: bury
+ *
+ * DESCRIPTION: Remember a member that is being removed
+ */
+void MP1Node::bury(MemberListEntry *e) {
+    member_tombstone t = {e->incarnation, e->getheartbeat(), par->getcurrtime()};
+    tombstones[Address::makeKey(e->getid(), e->getport())] = t;
+}
+
+/**
+ * FUNCTION NAME: pruneTombstones
+ *
+ * DESCRIPTION: Forget members removed ttl or more time units ago
+ */
+void MP1Node::pruneTombstones(long ttl) {
+    for (auto it = tombstones.begin(); it != tombstones.end(); ) {
+        if (par->getcurrtime() - it->second.since >= ttl)
+            it = tombstones.erase(it);
+        else
+            ++it;
+    }
+}
+
+/**
+ * FUNCTION NAME: hasFullMembership
+ *
+ * DESCRIPTION: Return true if this node is in the group and knows every other peer
+ */
+bool MP1Node::hasFullMembership() {
+    return memberNode->inGroup && (int)memberNode->memberList.size() == par->EN_GPSZ - 1;
+}
+
 
 /**
  * FUNCTION NAME: getJoinAddress
@@ -384,11 +1052,7 @@ void MP1Node::nodeLoopOps() {
  * DESCRIPTION: Returns the Address of the coordinator
  */
 Address MP1Node::getJoinAddress() {
-    Address joinaddr;
-
-    memset(&joinaddr, 0, sizeof(Address));
-    *(int *)(&joinaddr.addr) = 1;
-    *(short *)(&joinaddr.addr[4]) = 0;
+    Address joinaddr(1, 0);
 
     return joinaddr;
 }
@@ -396,10 +1060,12 @@ Address MP1Node::getJoinAddress() {
 /**
  * FUNCTION NAME: initMemberListTable
  *
- * DESCRIPTION: Initialize the membership list
+ * DESCRIPTION: Initialize the membership list, and the timer wheel sized so
+ * 				that the longest deadline, TREMOVE rounds, is within one turn
  */
 void MP1Node::initMemberListTable(Member *memberNode) {
 	memberNode->memberList.clear();
+	timers.reset(TREMOVE * par->GOSSIP_INTERVAL, par->getcurrtime());
 }
 
 /**
@@ -410,5 +1076,5 @@ void MP1Node::initMemberListTable(Member *memberNode) {
 void MP1Node::printAddress(Address *addr)
 {
     printf("%d.%d.%d.%d:%d \n",  addr->addr[0],addr->addr[1],addr->addr[2],
-                                                       addr->addr[3], *(short*)&addr->addr[4]) ;    
+                                                       addr->addr[3], addr->getPort()) ;    
 }
\ No newline at end of file
@@ -12,38 +12,45 @@
 #include "Log.h"
 #include "Params.h"
 #include "Member.h"
-#include "EmulNet.h"
+#include "Transport.h"
 #include "Queue.h"
+#include "MessageCodec.h"
+#include "Dissemination.h"
+#include "TimerWheel.h"
+#include "Coalescer.h"
 
 /**
  * Macros
  */
 #define TREMOVE 20
 #define TFAIL 5
-
-/*
- * Note: You can change/add any functions in MP1Node.{h,cpp}
- */
-
 /**
- * Message Types
+ * STRUCT NAME: member_tombstone
+ *
+ * DESCRIPTION: What was last known of a removed member. Gossip about it that is
+ * 				not newer than this cannot add it back.
  */
-enum MsgTypes{
-    JOINREQ,
-    JOINREP,
-	PING
-};
+typedef struct member_tombstone {
+	long incarnation;
+	long heartbeat;
+	// local time of the removal
+	long since;
+}member_tombstone;
 
 /**
- * STRUCT NAME: MessageHdr
+ * STRUCT NAME: swim_relay
  *
- * DESCRIPTION: Header and content of a message
+ * DESCRIPTION: A PINGREQ being served: an ACK from target goes back to origin
+ */
+typedef struct swim_relay {
+	Address target;
+	Address origin;
+	long since;
+}swim_relay;
+
+/*
+ * Note: You can change/add any functions in MP1Node.{h,cpp}
  */
-typedef struct MessageHdr {
-	enum MsgTypes msgType;
-	vector< MemberListEntry> memberList;
-	Address* addr;
-}MessageHdr;
 
 /**
  * CLASS NAME: MP1Node
@@ -52,14 +59,53 @@ typedef struct MessageHdr {
  */
 class MP1Node {
 private:
-	EmulNet *emulNet;
+	Transport *emulNet;
 	Log *log;
 	Params *par;
 	Member *memberNode;
 	char NULLADDR[6];
+	// membership list position the next PING starts from, moved past
+	// the entries carried whenever the list did not fit in one PING
+	int pingNext;
+	// time of the previous gossip round
+	long lastGossip;
+	// number of gossip rounds run so far
+	long gossipRounds;
+	// random source for gossip target selection
+	minstd_rand rng;
+	// indices into the membership list chosen for this round
+	vector<int> gossipTargets;
+	// addresses the current PING goes to
+	vector<Address> gossipAddrs;
+	// outgoing messages are encoded here, sized by maxPayloadSize()
+	vector<char> sendBuf;
+	// SWIM mode: members in probe order, and the next one to probe
+	vector<Address> probeOrder;
+	int probeNext;
+	// SWIM mode: member probed this period, when, and how far the probe got
+	Address probeTarget;
+	long probeStart;
+	bool probeAcked;
+	bool probeIndirect;
+	// membership events to piggyback, in SWIM mode and with PIGGYBACK
+	DisseminationBuffer dissemination;
+	// gossip mode: failure detection deadline of each member, by table slot
+	TimerWheel timers;
+	// table slots whose deadline came this tick
+	vector<int> expiredSlots;
+	// SWIM mode: PINGREQs being served
+	vector<swim_relay> relays;
+	// SWIM mode: members suspected, checked against suspectTimeout()
+	vector<Address> suspects;
+	// removed members by key
+	unordered_map<long, member_tombstone> tombstones;
+	// with COALESCE: messages held per destination until the end of the step
+	Coalescer outbox;
+	// messages of a received BATCH
+	vector< pair<char *, int> > batched;
 
 public:
-	MP1Node(Member *, Params *, EmulNet *, Log *, Address *);
+	MP1Node(Member *, Params *, Transport *, Log *, Address *);
 	Member * getMemberNode() {
 		return memberNode;
 	}
@@ -73,18 +119,39 @@ public:
 	void checkMessages();
 	bool recvCallBack(void *env, char *data, int size);
 	void nodeLoopOps();
+	long nextWakeup();
 	int isNullAddress(Address *addr);
 	Address getJoinAddress();
 	void initMemberListTable(Member *memberNode);
 	void printAddress(Address *addr);
 	virtual ~MP1Node();
-	void updateMemberList( MessageHdr* msg);
+	void updateMemberList(MessageView* msg);
 	void updateMemberList(MemberListEntry* e);
 	MemberListEntry* getMemberIfPresent( int id, short port);
+	int maxPayloadSize();
+	int encodeMessage(MsgTypes t, char *buf, int capacity, long since = -1);
+	void send(Address *to, char *data, int size);
 	void sendMessage(Address* toaddr, MsgTypes t);
-	void handlePing(MessageHdr* msg);
-	void update_src_member(MessageHdr* msg);
-	Address* createAddress(int id, short port);
+	void handlePing(MessageView* msg);
+	void pickGossipTargets(int k);
+	void armTimer(MemberListEntry *e);
+	void expireTimers();
+	bool hasFullMembership();
+	void swimLoopOps();
+	long suspectTimeout();
+	bool nextProbeTarget(Address *target);
+	void sendSwim(Address *to, MsgTypes t, Address *target);
+	void handleSwimMessage(MessageView *msg);
+	void applyEvents(MessageView *msg, bool spread);
+	MemberListEntry *addMember(Address *addr, long heartbeat, long incarnation, bool spread);
+	void suspect(MemberListEntry *e, long incarnation);
+	void declareFailed(Address *addr);
+	void queueEvent(MemberListEntry *e);
+	int piggyback(MessageWriter *writer);
+	bool refute(MemberListEntry *e);
+	bool isStale(MemberListEntry *e);
+	void bury(MemberListEntry *e);
+	void pruneTombstones(long ttl);
 };
 
 #endif /* _MP1NODE_H_ */
\ No newline at end of file
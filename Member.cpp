@@ -12,40 +12,37 @@
 q_elt::q_elt(void *elt, int size): elt(elt), size(size) {}
 
 /**
- * Copy constructor
+ * Compare two Address objects
+ * Return true/non-zero if they have the same ip address and port number 
+ * Return false/zero if they are different 
  */
-Address::Address(const Address &anotherAddress) {
-	// strcpy(addr, anotherAddress.addr);
-	memcpy(&addr, &anotherAddress.addr, sizeof(addr));
+bool Address::operator ==(const Address& anotherAddress) const {
+	return getKey() == anotherAddress.getKey();
 }
 
 /**
- * Assignment operator overloading
+ * Return true if the two Address objects differ
  */
-Address& Address::operator =(const Address& anotherAddress) {
-	// strcpy(addr, anotherAddress.addr);
-	memcpy(&addr, &anotherAddress.addr, sizeof(addr));
-	return *this;
+bool Address::operator !=(const Address& anotherAddress) const {
+	return getKey() != anotherAddress.getKey();
 }
 
 /**
- * Compare two Address objects
- * Return true/non-zero if they have the same ip address and port number 
- * Return false/zero if they are different 
+ * Order Address objects by id, then port
  */
-bool Address::operator ==(const Address& anotherAddress) {
-	return !memcmp(this->addr, anotherAddress.addr, sizeof(this->addr));
+bool Address::operator <(const Address& anotherAddress) const {
+	return getKey() < anotherAddress.getKey();
 }
 
 /**
  * Constructor
  */
-MemberListEntry::MemberListEntry(int id, short port, long heartbeat, long timestamp): id(id), port(port), heartbeat(heartbeat), timestamp(timestamp) {}
+MemberListEntry::MemberListEntry(int id, short port, long heartbeat, long timestamp): id(id), port(port), heartbeat(heartbeat), timestamp(timestamp), lastchanged(timestamp), incarnation(0), state(MEMBER_ALIVE) {}
 
 /**
  * Constuctor
  */
-MemberListEntry::MemberListEntry(int id, short port): id(id), port(port) {}
+MemberListEntry::MemberListEntry(int id, short port): id(id), port(port), lastchanged(0), incarnation(0), state(MEMBER_ALIVE) {}
 
 /**
  * Copy constructor
@@ -55,6 +52,9 @@ MemberListEntry::MemberListEntry(const MemberListEntry &anotherMLE) {
 	this->id = anotherMLE.id;
 	this->port = anotherMLE.port;
 	this->timestamp = anotherMLE.timestamp;
+	this->lastchanged = anotherMLE.lastchanged;
+	this->incarnation = anotherMLE.incarnation;
+	this->state = anotherMLE.state;
 }
 
 /**
@@ -66,6 +66,9 @@ MemberListEntry& MemberListEntry::operator =(const MemberListEntry &anotherMLE)
 	swap(id, temp.id);
 	swap(port, temp.port);
 	swap(timestamp, temp.timestamp);
+	swap(lastchanged, temp.lastchanged);
+	swap(incarnation, temp.incarnation);
+	swap(state, temp.state);
 	return *this;
 }
 
@@ -105,6 +108,15 @@ long MemberListEntry::gettimestamp() {
 	return timestamp;
 }
 
+/**
+ * FUNCTION NAME: getlastchanged
+ *
+ * DESCRIPTION: getter
+ */
+long MemberListEntry::getlastchanged() {
+	return lastchanged;
+}
+
 /**
  * FUNCTION NAME: setid
  *
@@ -141,6 +153,213 @@ void MemberListEntry::settimestamp(long timestamp) {
 	this->timestamp = timestamp;
 }
 
+/**
+ * FUNCTION NAME: setlastchanged
+ *
+ * DESCRIPTION: setter
+ */
+void MemberListEntry::setlastchanged(long lastchanged) {
+	this->lastchanged = lastchanged;
+}
+
+/**
+ * Constructor
+ */
+MemberTable::MemberTable(): index(16, -1) {}
+
+/**
+ * FUNCTION NAME: homeOf
+ *
+ * DESCRIPTION: Preferred index position of key (Fibonacci hashing)
+ */
+int MemberTable::homeOf(long key) {
+	return (int)(((unsigned long)key * 0x9E3779B97F4A7C15UL) >> 40) & (index.size() - 1);
+}
+
+/**
+ * FUNCTION NAME: probe
+ *
+ * DESCRIPTION: Return the index position holding key, or the empty position
+ * 				where it would be inserted
+ */
+int MemberTable::probe(long key) {
+	int mask = index.size() - 1;
+	int pos = homeOf(key);
+	while ( index[pos] != -1 ) {
+		MemberListEntry &e = slots[index[pos]];
+		if ( Address::makeKey(e.id, e.port) == key ) {
+			break;
+		}
+		pos = (pos + 1) & mask;
+	}
+	return pos;
+}
+
+/**
+ * FUNCTION NAME: grow
+ *
+ * DESCRIPTION: Double the hash index and reinsert every used slot
+ */
+void MemberTable::grow() {
+	index.assign(index.size() * 2, -1);
+	for ( int slot : order ) {
+		index[probe(Address::makeKey(slots[slot].id, slots[slot].port))] = slot;
+	}
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Return the entry for id:port, or nullptr if absent
+ */
+MemberListEntry *MemberTable::find(int id, short port) {
+	int pos = probe(Address::makeKey(id, port));
+	if ( index[pos] == -1 ) {
+		return nullptr;
+	}
+	return &slots[index[pos]];
+}
+
+/**
+ * FUNCTION NAME: insert
+ *
+ * DESCRIPTION: Add an entry, or overwrite the entry with the same id:port.
+ * 				Returns the stored entry.
+ */
+MemberListEntry *MemberTable::insert(const MemberListEntry &e) {
+	// keep the index at most half full
+	if ( 2 * ((int)order.size() + 1) > (int)index.size() ) {
+		grow();
+	}
+	int pos = probe(Address::makeKey(e.id, e.port));
+	if ( index[pos] != -1 ) {
+		slots[index[pos]] = e;
+		return &slots[index[pos]];
+	}
+	int slot;
+	if ( !freeSlots.empty() ) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+		slots[slot] = e;
+	}
+	else {
+		slot = slots.size();
+		slots.push_back(e);
+		slotPos.push_back(-1);
+	}
+	slotPos[slot] = order.size();
+	order.push_back(slot);
+	index[pos] = slot;
+	return &slots[slot];
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Remove the entry for id:port. Returns false if it was absent.
+ */
+bool MemberTable::erase(int id, short port) {
+	int mask = index.size() - 1;
+	int pos = probe(Address::makeKey(id, port));
+	int slot = index[pos];
+	if ( slot == -1 ) {
+		return false;
+	}
+
+	// Backward-shift deletion keeps every probe chain unbroken without tombstones
+	int hole = pos;
+	int next = (pos + 1) & mask;
+	while ( index[next] != -1 ) {
+		MemberListEntry &e = slots[index[next]];
+		int home = homeOf(Address::makeKey(e.id, e.port));
+		// move the entry into the hole unless its home lies cyclically in (hole, next]
+		if ( ((next - home) & mask) >= ((next - hole) & mask) ) {
+			index[hole] = index[next];
+			hole = next;
+		}
+		next = (next + 1) & mask;
+	}
+	index[hole] = -1;
+
+	// Swap the last used slot into the freed position of the dense list
+	int at = slotPos[slot];
+	int last = order.back();
+	order[at] = last;
+	slotPos[last] = at;
+	order.pop_back();
+	slotPos[slot] = -1;
+	freeSlots.push_back(slot);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Number of entries in the table
+ */
+int MemberTable::size() {
+	return order.size();
+}
+
+/**
+ * FUNCTION NAME: empty
+ *
+ * DESCRIPTION: Return true if the table holds no entry
+ */
+bool MemberTable::empty() {
+	return order.empty();
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Remove every entry
+ */
+void MemberTable::clear() {
+	slots.clear();
+	slotPos.clear();
+	order.clear();
+	freeSlots.clear();
+	index.assign(16, -1);
+}
+
+/**
+ * Return the i-th entry in iteration order
+ */
+MemberListEntry& MemberTable::operator [](int i) {
+	return slots[order[i]];
+}
+
+/**
+ * FUNCTION NAME: slotOf
+ *
+ * DESCRIPTION: Stable slot number of the i-th entry in iteration order
+ */
+int MemberTable::slotOf(int i) {
+	return order[i];
+}
+
+/**
+ * FUNCTION NAME: slotOf
+ *
+ * DESCRIPTION: Stable slot number of an entry stored in the table
+ */
+int MemberTable::slotOf(const MemberListEntry *e) {
+	return e - &slots[0];
+}
+
+/**
+ * FUNCTION NAME: atSlot
+ *
+ * DESCRIPTION: Return the entry stored in a slot, or nullptr if the slot is free
+ */
+MemberListEntry *MemberTable::atSlot(int slot) {
+	if ( slot < 0 || slot >= (int)slotPos.size() || slotPos[slot] == -1 ) {
+		return nullptr;
+	}
+	return &slots[slot];
+}
+
 /**
  * Copy Constructor
  */
@@ -151,6 +370,7 @@ Member::Member(const Member &anotherMember) {
 	this->bFailed = anotherMember.bFailed;
 	this->nnb = anotherMember.nnb;
 	this->heartbeat = anotherMember.heartbeat;
+	this->incarnation = anotherMember.incarnation;
 	this->pingCounter = anotherMember.pingCounter;
 	this->timeOutCounter = anotherMember.timeOutCounter;
 	this->memberList = anotherMember.memberList;
@@ -168,6 +388,7 @@ Member& Member::operator =(const Member& anotherMember) {
 	this->bFailed = anotherMember.bFailed;
 	this->nnb = anotherMember.nnb;
 	this->heartbeat = anotherMember.heartbeat;
+	this->incarnation = anotherMember.incarnation;
 	this->pingCounter = anotherMember.pingCounter;
 	this->timeOutCounter = anotherMember.timeOutCounter;
 	this->memberList = anotherMember.memberList;
@@ -24,17 +24,23 @@ public:
 /**
  * CLASS NAME: Address
  *
- * DESCRIPTION: Class representing the address of a single node
+ * DESCRIPTION: Class representing the address of a single node.
+ * 				The six bytes hold the node id followed by the port, both
+ * 				little-endian. getKey() packs them into one integer so that
+ * 				hashing and comparison need no string work.
  */
 class Address {
 public:
 	char addr[6];
 	Address() {}
+	constexpr Address(int id, short port): addr{(char)id, (char)(id >> 8), (char)(id >> 16), (char)(id >> 24), (char)port, (char)(port >> 8)} {}
 	// Copy constructor
-	Address(const Address &anotherAddress);
+	Address(const Address &anotherAddress) = default;
 	 // Overloaded = operator
-	Address& operator =(const Address &anotherAddress);
-	bool operator ==(const Address &anotherAddress);
+	Address& operator =(const Address &anotherAddress) = default;
+	bool operator ==(const Address &anotherAddress) const;
+	bool operator !=(const Address &anotherAddress) const;
+	bool operator <(const Address &anotherAddress) const;
 	Address(string address) {
 		size_t pos = address.find(":");
 		int id = stoi(address.substr(0, pos));
@@ -43,17 +49,46 @@ public:
 		memcpy(&addr[4], &port, sizeof(short));
 	}
 	string getAddress() {
-		int id = 0;
-		short port;
-		memcpy(&id, &addr[0], sizeof(int));
-		memcpy(&port, &addr[4], sizeof(short));
-		return to_string(id) + ":" + to_string(port);
+		return to_string(getId()) + ":" + to_string(getPort());
+	}
+	constexpr int getId() const {
+		return (int)((unsigned char)addr[0] | (unsigned char)addr[1] << 8 | (unsigned char)addr[2] << 16 | (unsigned)(unsigned char)addr[3] << 24);
+	}
+	constexpr short getPort() const {
+		return (short)((unsigned char)addr[4] | (unsigned char)addr[5] << 8);
+	}
+	constexpr long getKey() const {
+		return makeKey(getId(), getPort());
+	}
+	static constexpr long makeKey(int id, short port) {
+		return ((long)(unsigned int)id << 16) | (unsigned short)port;
 	}
 	void init() {
 		memset(&addr, 0, sizeof(addr));
 	}
 };
 
+/**
+ * STRUCT NAME: AddressHash
+ *
+ * DESCRIPTION: Hash functor over the packed key, for unordered containers
+ */
+struct AddressHash {
+	size_t operator()(const Address &address) const {
+		return (size_t)((unsigned long)address.getKey() * 0x9E3779B97F4A7C15UL);
+	}
+};
+
+/**
+ * Member states. A suspected member is still listed and may refute the
+ * suspicion with a higher incarnation; a failed one is removed.
+ */
+enum MemberStates{
+	MEMBER_ALIVE,
+	MEMBER_SUSPECT,
+	MEMBER_FAILED
+};
+
 /**
  * CLASS NAME: MemberListEntry
  *
@@ -65,19 +100,66 @@ public:
 	short port;
 	long heartbeat;
 	long timestamp;
+	// local time at which this entry was last updated
+	long lastchanged;
+	// raised only by the member itself, to refute a suspicion
+	long incarnation;
+	enum MemberStates state;
 	MemberListEntry(int id, short port, long heartbeat, long timestamp);
 	MemberListEntry(int id, short port);
-	MemberListEntry(): id(0), port(0), heartbeat(0), timestamp(0) {}
+	MemberListEntry(): id(0), port(0), heartbeat(0), timestamp(0), lastchanged(0), incarnation(0), state(MEMBER_ALIVE) {}
 	MemberListEntry(const MemberListEntry &anotherMLE);
 	MemberListEntry& operator =(const MemberListEntry &anotherMLE);
 	int getid();
 	short getport();
 	long getheartbeat();
 	long gettimestamp();
+	long getlastchanged();
 	void setid(int id);
 	void setport(short port);
 	void setheartbeat(long hearbeat);
 	void settimestamp(long timestamp);
+	void setlastchanged(long lastchanged);
+};
+
+/**
+ * CLASS NAME: MemberTable
+ *
+ * DESCRIPTION: Membership table keyed by packed id:port.
+ * 				Entries live in stable slots found through an open-addressing
+ * 				(linear probing) index, so lookup, insert and erase are O(1).
+ * 				A dense list of used slots keeps iteration as cheap as a vector:
+ * 				table[i] for 0 <= i < size() visits every entry once. Erasing
+ * 				moves the last entry of the dense list into position i, so erase
+ * 				while iterating backwards. Entry pointers are invalidated by insert.
+ */
+class MemberTable {
+private:
+	// stable entry storage
+	vector<MemberListEntry> slots;
+	// position of each slot in order, -1 if the slot is free
+	vector<int> slotPos;
+	// used slots, densely packed
+	vector<int> order;
+	// free slots available for reuse
+	vector<int> freeSlots;
+	// hash index holding slot numbers, -1 if empty; size is a power of two
+	vector<int> index;
+	int homeOf(long key);
+	int probe(long key);
+	void grow();
+public:
+	MemberTable();
+	MemberListEntry *find(int id, short port);
+	MemberListEntry *insert(const MemberListEntry &e);
+	bool erase(int id, short port);
+	int size();
+	bool empty();
+	void clear();
+	MemberListEntry& operator [](int i);
+	int slotOf(int i);
+	int slotOf(const MemberListEntry *e);
+	MemberListEntry *atSlot(int slot);
 };
 
 /**
@@ -100,20 +182,22 @@ public:
 	int nnb;
 	// the node's own heartbeat
 	long heartbeat;
+	// the node's own incarnation, raised each time it refutes a suspicion
+	long incarnation;
 	// counter for next ping
 	int pingCounter;
 	// counter for ping timeout
 	int timeOutCounter;
 	// Membership table
-	vector<MemberListEntry> memberList;
-	// My position in the membership table
-	vector<MemberListEntry>::iterator myPos;
+	MemberTable memberList;
+	// My slot in the membership table
+	int myPos;
 	// Queue for failure detection messages
 	queue<q_elt> mp1q;
 	/**
 	 * Constructor
 	 */
-	Member(): inited(false), inGroup(false), bFailed(false), nnb(0), heartbeat(0), pingCounter(0), timeOutCounter(0) {}
+	Member(): inited(false), inGroup(false), bFailed(false), nnb(0), heartbeat(0), incarnation(0), pingCounter(0), timeOutCounter(0), myPos(-1) {}
 	// copy constructor
 	Member(const Member &anotherMember);
 	// Assignment operator overloading
@@ -0,0 +1,203 @@
+/**********************************
+ * FILE NAME: MessageCodec.cpp
+ *
+ * DESCRIPTION: Definition of MessageWriter and MessageView classes
+ **********************************/
+
+#include "MessageCodec.h"
+
+/**
+ * Constructor
+ *
+ * Writes the message header. If the header alone does not fit the writer is
+ * left invalid and every append is refused. A null target is written as zero.
+ */
+MessageWriter::MessageWriter(char *buf, int capacity, enum MsgTypes msgType, Address *from, long heartbeat, long incarnation, Address *target): buf(buf), capacity(capacity), length(0), numEntries(0) {
+	if ( capacity < MSG_HDR_SIZE ) {
+		return;
+	}
+	int hb = (int)heartbeat;
+	int inc = (int)incarnation;
+	buf[0] = (char)msgType;
+	memcpy(&buf[1], &from->addr, sizeof(from->addr));
+	if ( target != nullptr ) {
+		memcpy(&buf[7], &target->addr, sizeof(target->addr));
+	}
+	else {
+		memset(&buf[7], 0, sizeof(from->addr));
+	}
+	memcpy(&buf[13], &hb, sizeof(int));
+	memcpy(&buf[17], &inc, sizeof(int));
+	memcpy(&buf[21], &numEntries, sizeof(numEntries));
+	length = MSG_HDR_SIZE;
+}
+
+/**
+ * FUNCTION NAME: append
+ *
+ * DESCRIPTION: Append one membership entry to the message
+ *
+ * RETURNS:
+ * false if the entry does not fit in the buffer
+ */
+bool MessageWriter::append(MemberListEntry *e) {
+	if ( !isValid() || length + MSG_ENTRY_SIZE > capacity || numEntries == 0xFFFF ) {
+		return false;
+	}
+	int heartbeat = (int)e->heartbeat;
+	int timestamp = (int)e->timestamp;
+	int incarnation = (int)e->incarnation;
+	char *p = buf + length;
+	memcpy(p, &e->id, sizeof(int));
+	memcpy(p + 4, &e->port, sizeof(short));
+	memcpy(p + 6, &heartbeat, sizeof(int));
+	memcpy(p + 10, &timestamp, sizeof(int));
+	memcpy(p + 14, &incarnation, sizeof(int));
+	p[18] = (char)e->state;
+	length += MSG_ENTRY_SIZE;
+	numEntries++;
+	memcpy(&buf[21], &numEntries, sizeof(numEntries));
+	return true;
+}
+
+/**
+ * FUNCTION NAME: isValid
+ *
+ * DESCRIPTION: Return true if the header was written
+ */
+bool MessageWriter::isValid() {
+	return length >= MSG_HDR_SIZE;
+}
+
+/**
+ * FUNCTION NAME: getSize
+ *
+ * DESCRIPTION: Number of bytes encoded so far
+ */
+int MessageWriter::getSize() {
+	return length;
+}
+
+/**
+ * FUNCTION NAME: getNumEntries
+ *
+ * DESCRIPTION: Number of entries encoded so far
+ */
+int MessageWriter::getNumEntries() {
+	return numEntries;
+}
+
+/**
+ * FUNCTION NAME: encodedSize
+ *
+ * DESCRIPTION: Size in bytes of a message carrying numEntries entries
+ */
+int MessageWriter::encodedSize(int numEntries) {
+	return MSG_HDR_SIZE + numEntries * MSG_ENTRY_SIZE;
+}
+
+/**
+ * Constructor
+ *
+ * The view is valid only if the buffer holds a full header and every entry
+ * the header announces.
+ */
+MessageView::MessageView(char *data, int size): data(data), size(size), valid(false) {
+	if ( size < MSG_HDR_SIZE ) {
+		return;
+	}
+	valid = (MessageWriter::encodedSize(getNumEntries()) <= size);
+}
+
+/**
+ * FUNCTION NAME: isValid
+ *
+ * DESCRIPTION: Return true if the buffer holds a well-formed message
+ */
+bool MessageView::isValid() {
+	return valid;
+}
+
+/**
+ * FUNCTION NAME: getType
+ *
+ * DESCRIPTION: getter
+ */
+enum MsgTypes MessageView::getType() {
+	return (enum MsgTypes)data[0];
+}
+
+/**
+ * FUNCTION NAME: getSender
+ *
+ * DESCRIPTION: getter
+ */
+Address MessageView::getSender() {
+	Address sender;
+	memcpy(&sender.addr, &data[1], sizeof(sender.addr));
+	return sender;
+}
+
+/**
+ * FUNCTION NAME: getTarget
+ *
+ * DESCRIPTION: getter
+ */
+Address MessageView::getTarget() {
+	Address target;
+	memcpy(&target.addr, &data[7], sizeof(target.addr));
+	return target;
+}
+
+/**
+ * FUNCTION NAME: getHeartbeat
+ *
+ * DESCRIPTION: getter
+ */
+long MessageView::getHeartbeat() {
+	int heartbeat;
+	memcpy(&heartbeat, &data[13], sizeof(int));
+	return heartbeat;
+}
+
+/**
+ * FUNCTION NAME: getIncarnation
+ *
+ * DESCRIPTION: getter
+ */
+long MessageView::getIncarnation() {
+	int incarnation;
+	memcpy(&incarnation, &data[17], sizeof(int));
+	return incarnation;
+}
+
+/**
+ * FUNCTION NAME: getNumEntries
+ *
+ * DESCRIPTION: getter
+ */
+int MessageView::getNumEntries() {
+	unsigned short numEntries;
+	memcpy(&numEntries, &data[21], sizeof(numEntries));
+	return numEntries;
+}
+
+/**
+ * FUNCTION NAME: getEntry
+ *
+ * DESCRIPTION: Decode the i-th membership entry of the message
+ */
+MemberListEntry MessageView::getEntry(int i) {
+	int id, heartbeat, timestamp, incarnation;
+	short port;
+	char *p = data + MSG_HDR_SIZE + i * MSG_ENTRY_SIZE;
+	memcpy(&id, p, sizeof(int));
+	memcpy(&port, p + 4, sizeof(short));
+	memcpy(&heartbeat, p + 6, sizeof(int));
+	memcpy(&timestamp, p + 10, sizeof(int));
+	memcpy(&incarnation, p + 14, sizeof(int));
+	MemberListEntry e(id, port, heartbeat, timestamp);
+	e.incarnation = incarnation;
+	e.state = (enum MemberStates)p[18];
+	return e;
+}
@@ -0,0 +1,105 @@
+/**********************************
+ * FILE NAME: MessageCodec.h
+ *
+ * DESCRIPTION: Wire format of membership protocol messages.
+ * 				Header file of MessageWriter and MessageView classes.
+ **********************************/
+
+#ifndef _MESSAGECODEC_H_
+#define _MESSAGECODEC_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+
+/*
+ * Macros
+ */
+// type (1) + sender address (6) + target address (6) + sender heartbeat (4) + sender incarnation (4) + number of entries (2)
+#define MSG_HDR_SIZE 23
+// id (4) + port (2) + heartbeat (4) + timestamp (4) + incarnation (4) + state (1)
+#define MSG_ENTRY_SIZE 19
+// type (1) + number of messages (2)
+#define BATCH_HDR_SIZE 3
+// length in front of each message of a BATCH
+#define BATCH_LEN_SIZE 4
+
+/**
+ * Message Types
+ */
+enum MsgTypes{
+    JOINREQ,
+    JOINREP,
+	PING,
+	// SWIM mode: answer to a PING, naming the member that was probed
+	ACK,
+	// SWIM mode: ask the receiver to probe the target on the sender's behalf
+	PINGREQ,
+	// with COALESCE: envelope of several messages to the same destination
+	BATCH
+};
+
+/*
+ * Wire layout, all fields packed in host byte order:
+ *
+ *   +------+----------------+----------------+-----------+-------------+-------------+----------------------+
+ *   | type | sender address | target address | heartbeat | incarnation | num entries | entries[num entries] |
+ *   |  1B  |       6B       |       6B       |    4B     |     4B      |     2B      | MSG_ENTRY_SIZE each  |
+ *   +------+----------------+----------------+-----------+-------------+-------------+----------------------+
+ *
+ * The target is only meaningful for ACK and PINGREQ and is zero otherwise.
+ *
+ * A BATCH frames whole messages, each preceded by its length:
+ *
+ *   +-------+--------------+-----+---------+-----+---------+-----+
+ *   | BATCH | num messages | len | message | len | message | ... |
+ *   |  1B   |      2B      | 4B  | len B   | 4B  | len B   |     |
+ *   +-------+--------------+-----+---------+-----+---------+-----+
+ */
+
+/**
+ * CLASS NAME: MessageWriter
+ *
+ * DESCRIPTION: Encodes a message into a caller-provided buffer.
+ * 				Entries that do not fit in the buffer are refused, so the
+ * 				encoded size never exceeds the given capacity.
+ */
+class MessageWriter {
+private:
+	char *buf;
+	int capacity;
+	int length;
+	unsigned short numEntries;
+public:
+	MessageWriter(char *buf, int capacity, enum MsgTypes msgType, Address *from, long heartbeat, long incarnation, Address *target = nullptr);
+	bool append(MemberListEntry *e);
+	bool isValid();
+	int getSize();
+	int getNumEntries();
+	static int encodedSize(int numEntries);
+};
+
+/**
+ * CLASS NAME: MessageView
+ *
+ * DESCRIPTION: Read-only view over an encoded message.
+ * 				Decodes fields on access straight from the received buffer
+ * 				without copying or allocating.
+ */
+class MessageView {
+private:
+	char *data;
+	int size;
+	bool valid;
+public:
+	MessageView(char *data, int size);
+	bool isValid();
+	enum MsgTypes getType();
+	Address getSender();
+	Address getTarget();
+	long getHeartbeat();
+	long getIncarnation();
+	int getNumEntries();
+	MemberListEntry getEntry(int i);
+};
+
+#endif /* _MESSAGECODEC_H_ */
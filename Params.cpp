@@ -11,6 +11,58 @@
  */
 Params::Params(): PORTNUM(8001) {}
 
+/**
+ * FUNCTION NAME: setdefaults
+ *
+ * DESCRIPTION: Set every parameter to its default, as for a 10 node group
+ * 				without failures or message drops
+ */
+void Params::setdefaults() {
+	MAX_NNB = 10;
+	SINGLE_FAILURE = 0;
+	DROP_MSG = 0;
+	MSG_DROP_PROB = 0;
+	EN_GPSZ = MAX_NNB;
+	STEP_RATE = .25;
+	MAX_MSG_SIZE = 4000;
+	globaltime = 0;
+	dropmsg = 0;
+	allNodesJoined = 0;
+	DELTA_GOSSIP = 0;
+	FULL_SYNC_INTERVAL = 10;
+	GOSSIP_FANOUT = 0;
+	GOSSIP_INTERVAL = 1;
+	PIGGYBACK = 0;
+	PIGGYBACK_LAMBDA = 3;
+	SWIM = 0;
+	SWIM_PERIOD = 8;
+	SWIM_ACK_TIMEOUT = 3;
+	SWIM_INDIRECT = 3;
+	SWIM_SUSPECT_MULT = 2;
+	SWIM_SUSPECT_TIMEOUT = 0;
+	EN_BUFFSIZE = 0;
+	TOTAL_RUNNING_TIME = 700;
+	BENCH_REPORT = 0;
+	QUIET_LOG = 0;
+	THREADS = 1;
+	DETERMINISTIC = 1;
+	TRANSPORT = 0;
+	UDP_BASE_PORT = 30000;
+	PROCESSES = 2;
+	SHM_RING_KB = 4096;
+	SIM_ENGINE = 0;
+	LATENCY = 1;
+	ZONES = 1;
+	RACKS_PER_ZONE = 1;
+	RACK_LATENCY = 0;
+	ZONE_LATENCY = 0;
+	JITTER = 0;
+	EGRESS_BYTES = 0;
+	EGRESS_BACKLOG = 0;
+	COALESCE = 0;
+	SEED = 0;
+}
+
 /**
  * FUNCTION NAME: setparams
  *
@@ -18,20 +70,24 @@ Params::Params(): PORTNUM(8001) {}
  */
 void Params::setparams(char *config_file) {
 	FILE *fp = fopen(config_file,"r");
+	char key[64];
+	double value;
+
+	setdefaults();
 
 	fscanf(fp,"MAX_NNB: %d", &MAX_NNB);
 	fscanf(fp,"\nSINGLE_FAILURE: %d", &SINGLE_FAILURE);
 	fscanf(fp,"\nDROP_MSG: %d", &DROP_MSG);
 	fscanf(fp,"\nMSG_DROP_PROB: %lf", &MSG_DROP_PROB);
 
+	// Optional settings follow, one "KEY: value" per line
+	while ( fscanf(fp, " %63[A-Z_]: %lf", key, &value) == 2 ) {
+		setoptional(key, value);
+	}
+
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
 	EN_GPSZ = MAX_NNB;
-	STEP_RATE=.25;
-	MAX_MSG_SIZE = 4000;
-	globaltime = 0;
-	dropmsg = 0;
-	allNodesJoined = 0;
 	for ( unsigned int i = 0; i < EN_GPSZ; i++ ) {
 		allNodesJoined += i;
 	}
@@ -39,6 +95,121 @@ void Params::setparams(char *config_file) {
 	return;
 }
 
+/**
+ * FUNCTION NAME: setoptional
+ *
+ * DESCRIPTION: Set an optional parameter read from the config file.
+ * 				Unknown keys are ignored.
+ */
+void Params::setoptional(char *key, double value) {
+	if ( 0 == strcmp(key, "DELTA_GOSSIP") ) {
+		DELTA_GOSSIP = (int)value;
+	}
+	else if ( 0 == strcmp(key, "FULL_SYNC_INTERVAL") ) {
+		FULL_SYNC_INTERVAL = (int)value;
+	}
+	else if ( 0 == strcmp(key, "GOSSIP_FANOUT") ) {
+		GOSSIP_FANOUT = (int)value;
+	}
+	else if ( 0 == strcmp(key, "GOSSIP_INTERVAL") ) {
+		// TFAIL and TREMOVE are counted in intervals, so it takes at least one time unit
+		GOSSIP_INTERVAL = max(1, (int)value);
+	}
+	else if ( 0 == strcmp(key, "PIGGYBACK") ) {
+		PIGGYBACK = (int)value;
+	}
+	else if ( 0 == strcmp(key, "PIGGYBACK_LAMBDA") ) {
+		PIGGYBACK_LAMBDA = (int)value;
+	}
+	else if ( 0 == strcmp(key, "SWIM") ) {
+		SWIM = (int)value;
+	}
+	else if ( 0 == strcmp(key, "SWIM_PERIOD") ) {
+		SWIM_PERIOD = (int)value;
+	}
+	else if ( 0 == strcmp(key, "SWIM_ACK_TIMEOUT") ) {
+		SWIM_ACK_TIMEOUT = (int)value;
+	}
+	else if ( 0 == strcmp(key, "SWIM_INDIRECT") ) {
+		SWIM_INDIRECT = (int)value;
+	}
+	else if ( 0 == strcmp(key, "SWIM_SUSPECT_MULT") ) {
+		SWIM_SUSPECT_MULT = max(1, (int)value);
+	}
+	else if ( 0 == strcmp(key, "SWIM_SUSPECT_TIMEOUT") ) {
+		SWIM_SUSPECT_TIMEOUT = (int)value;
+	}
+	else if ( 0 == strcmp(key, "EN_BUFFSIZE") ) {
+		EN_BUFFSIZE = (int)value;
+	}
+	else if ( 0 == strcmp(key, "TOTAL_RUNNING_TIME") ) {
+		TOTAL_RUNNING_TIME = (int)value;
+	}
+	else if ( 0 == strcmp(key, "MAX_MSG_SIZE") ) {
+		MAX_MSG_SIZE = max(MIN_MSG_SIZE, (int)value);
+	}
+	else if ( 0 == strcmp(key, "STEP_RATE") ) {
+		STEP_RATE = value;
+	}
+	else if ( 0 == strcmp(key, "BENCH_REPORT") ) {
+		BENCH_REPORT = (int)value;
+	}
+	else if ( 0 == strcmp(key, "QUIET_LOG") ) {
+		QUIET_LOG = (int)value;
+	}
+	else if ( 0 == strcmp(key, "THREADS") ) {
+		THREADS = (int)value;
+	}
+	else if ( 0 == strcmp(key, "TRANSPORT") ) {
+		TRANSPORT = (int)value;
+	}
+	else if ( 0 == strcmp(key, "UDP_BASE_PORT") ) {
+		UDP_BASE_PORT = (int)value;
+	}
+	else if ( 0 == strcmp(key, "PROCESSES") ) {
+		PROCESSES = (int)value;
+	}
+	else if ( 0 == strcmp(key, "SHM_RING_KB") ) {
+		SHM_RING_KB = (int)value;
+	}
+	else if ( 0 == strcmp(key, "DETERMINISTIC") ) {
+		DETERMINISTIC = (int)value;
+	}
+	else if ( 0 == strcmp(key, "SIM_ENGINE") ) {
+		SIM_ENGINE = (int)value;
+	}
+	else if ( 0 == strcmp(key, "LATENCY") ) {
+		LATENCY = (int)value;
+	}
+	else if ( 0 == strcmp(key, "ZONES") ) {
+		ZONES = (int)value;
+	}
+	else if ( 0 == strcmp(key, "RACKS_PER_ZONE") ) {
+		RACKS_PER_ZONE = (int)value;
+	}
+	else if ( 0 == strcmp(key, "RACK_LATENCY") ) {
+		RACK_LATENCY = (int)value;
+	}
+	else if ( 0 == strcmp(key, "ZONE_LATENCY") ) {
+		ZONE_LATENCY = (int)value;
+	}
+	else if ( 0 == strcmp(key, "JITTER") ) {
+		JITTER = value;
+	}
+	else if ( 0 == strcmp(key, "EGRESS_BYTES") ) {
+		EGRESS_BYTES = (int)value;
+	}
+	else if ( 0 == strcmp(key, "EGRESS_BACKLOG") ) {
+		EGRESS_BACKLOG = (int)value;
+	}
+	else if ( 0 == strcmp(key, "COALESCE") ) {
+		COALESCE = (int)value;
+	}
+	else if ( 0 == strcmp(key, "SEED") ) {
+		SEED = (unsigned int)value;
+	}
+}
+
 /**
  * FUNCTION NAME: getcurrtime
  *
@@ -11,6 +11,9 @@
 #include "Params.h"
 #include "Member.h"
 
+// smallest MAX_MSG_SIZE accepted, room for the transport header and a message header
+#define MIN_MSG_SIZE 256
+
 enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST };
 
 /**
@@ -25,14 +28,49 @@ public:
 	double MSG_DROP_PROB;		// message drop probability
 	double STEP_RATE;		    // dictates the rate of insertion
 	int EN_GPSZ;			    // actual number of peers
-	int MAX_MSG_SIZE;
+	int MAX_MSG_SIZE;			// largest message in bytes, transport header included
 	int DROP_MSG;
 	int dropmsg;
 	int globaltime;
 	int allNodesJoined;
 	short PORTNUM;
+	int DELTA_GOSSIP;			// gossip only entries changed since the last round
+	int FULL_SYNC_INTERVAL;		// rounds between full membership list syncs in delta mode
+	int GOSSIP_FANOUT;			// number of random targets per round, 0 for all-to-all
+	int GOSSIP_INTERVAL;		// time units between gossip rounds
+	int PIGGYBACK;				// PINGs carry pending membership events instead of the list
+	int PIGGYBACK_LAMBDA;		// each event is piggybacked PIGGYBACK_LAMBDA * log2(N) times
+	int SWIM;					// run the SWIM probe protocol instead of heartbeat gossip
+	int SWIM_PERIOD;			// time units per SWIM protocol period
+	int SWIM_ACK_TIMEOUT;		// time units to wait for a direct ACK before sending PINGREQs
+	int SWIM_INDIRECT;			// members asked to probe through PINGREQ
+	int SWIM_SUSPECT_MULT;		// a suspect has SWIM_SUSPECT_MULT * log2(N) periods to refute
+	int SWIM_SUSPECT_TIMEOUT;	// if set, time units a suspect has to refute instead
+	int EN_BUFFSIZE;			// max messages in flight in EmulNet, 0 for unbounded
+	int TOTAL_RUNNING_TIME;		// time units to simulate
+	int BENCH_REPORT;			// append a scale benchmark result to bench.jsonl
+	int QUIET_LOG;				// leave membership events out of dbg.log
+	int THREADS;				// worker threads stepping the nodes
+	int TRANSPORT;				// network backend, see TransportTypes
+	int UDP_BASE_PORT;			// node id is added to get the UDP transport port
+	int PROCESSES;				// worker processes of the shared-memory transport
+	int SHM_RING_KB;			// size of each shared-memory ring between two workers
+	int DETERMINISTIC;			// with THREADS > 1, replay the serial order of sends and log lines
+	int SIM_ENGINE;				// 0 steps every node every time unit, 1 runs the discrete-event engine
+	int LATENCY;				// with the event engine, time units between a send and its delivery within a rack
+	int ZONES;					// zones the nodes are spread over
+	int RACKS_PER_ZONE;			// racks per zone
+	int RACK_LATENCY;			// delay between racks of a zone, 0 for LATENCY
+	int ZONE_LATENCY;			// delay between zones, 0 for RACK_LATENCY
+	double JITTER;				// mean extra delay, as a fraction of the link's delay
+	int EGRESS_BYTES;			// payload bytes a node sends per time unit, 0 for unlimited
+	int EGRESS_BACKLOG;			// time units of queued egress past which messages are dropped, 0 for unbounded
+	int COALESCE;				// frame all messages a node sends one destination in a step into one envelope
+	unsigned int SEED;			// seed of every random choice, 0 to take it from the clock
 	Params();
+	void setdefaults();
 	void setparams(char *);
+	void setoptional(char *, double);
 	int getcurrtime();
 };
 
@@ -0,0 +1,422 @@
+/**********************************
+ * FILE NAME: ShmNet.cpp
+ *
+ * DESCRIPTION: Shared-memory multi-process transport definition
+ **********************************/
+
+#include "ShmNet.h"
+
+/**
+ * Constructor
+ *
+ * Maps one shared anonymous segment holding the control block, the per-worker
+ * reports, the full membership flags, the message counts and all rings. It is
+ * created before the workers are forked, so every process sees it at the
+ * same address.
+ */
+ShmNet::ShmNet(Params *p): par(p), nextid(1), self(-1), lastDrain(-1) {
+	workers = max(1, par->PROCESSES);
+	ticks = par->TOTAL_RUNNING_TIME;
+	ringBytes = (long)max(1, par->SHM_RING_KB) * 1024;
+
+	size_t ctlSize = (sizeof(shm_control) + 63) & ~(size_t)63;
+	size_t statsSize = (sizeof(shm_worker) * workers + 63) & ~(size_t)63;
+	size_t flagsSize = ((size_t)workers * ticks + 63) & ~(size_t)63;
+	size_t countsSize = ((size_t)(par->EN_GPSZ + 1) * ticks * sizeof(int) + 63) & ~(size_t)63;
+	size_t ringSize = sizeof(shm_ring) + ringBytes;
+	segmentSize = ctlSize + statsSize + flagsSize + 2 * countsSize + (size_t)workers * workers * ringSize;
+
+	segment = (char *)mmap(NULL, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if ( segment == MAP_FAILED ) {
+		perror("ShmNet mmap");
+		exit(FAILURE);
+	}
+	ctl = new (segment) shm_control();
+	workerStats = (shm_worker *)(segment + ctlSize);
+	fullFlags = segment + ctlSize + statsSize;
+	sentCounts = (int *)(fullFlags + flagsSize);
+	recvCounts = (int *)((char *)sentCounts + countsSize);
+	rings = (char *)recvCounts + countsSize;
+	for ( int from = 0; from < workers; from++ ) {
+		for ( int to = 0; to < workers; to++ ) {
+			new (ring(from, to)) shm_ring();
+		}
+	}
+}
+
+/**
+ * Destructor
+ */
+ShmNet::~ShmNet() {
+	munmap(segment, segmentSize);
+}
+
+/**
+ * FUNCTION NAME: ring
+ *
+ * DESCRIPTION: Ring carrying messages from worker from to worker to
+ */
+shm_ring *ShmNet::ring(int from, int to) {
+	return (shm_ring *)(rings + (size_t)(from * workers + to) * (sizeof(shm_ring) + ringBytes));
+}
+
+/**
+ * FUNCTION NAME: ownerOf
+ *
+ * DESCRIPTION: Worker process that steps the node with this id
+ */
+int ShmNet::ownerOf(int id) {
+	return (id - 1) % workers;
+}
+
+/**
+ * FUNCTION NAME: getWorkers
+ *
+ * DESCRIPTION: Number of worker processes
+ */
+int ShmNet::getWorkers() {
+	return workers;
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Give the node the next id
+ */
+void *ShmNet::ENinit(Address *myaddr, short port) {
+	int id = nextid++;
+	*myaddr = Address(id, 0);
+	if ( id >= (int)inbox.size() ) {
+		inbox.resize(id + 1);
+	}
+	seed_seq seq{par->SEED, (unsigned int)id};
+	while ( id >= (int)dropRng.size() ) {
+		dropRng.push_back(minstd_rand());
+	}
+	dropRng[id].seed(seq);
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Append a message to the ring from this worker to the worker
+ * 				owning the destination
+ *
+ * RETURNS:
+ * size
+ */
+int ShmNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
+	int src = myaddr->getId();
+	int dst = toaddr->getId();
+	int time = par->getcurrtime();
+
+	if ( size + SHM_REC_HDR >= par->MAX_MSG_SIZE ) {
+		ctl->oversizeDrops++;
+		return 0;
+	}
+	if ( par->dropmsg && (int)(dropRng[src]() % 100) < (int)(par->MSG_DROP_PROB * 100) ) {
+		return 0;
+	}
+
+	shm_ring *r = ring(ownerOf(src), ownerOf(dst));
+	char *base = (char *)(r + 1);
+	long rec = (SHM_REC_HDR + size + SHM_ALIGN - 1) & ~(long)(SHM_ALIGN - 1);
+	long tail = r->tail.load(memory_order_relaxed);
+	long head = r->head.load(memory_order_acquire);
+	long pos = tail % ringBytes;
+	// a record never straddles the end; the rest of the ring is skipped instead
+	long skip = (ringBytes - pos < rec) ? ringBytes - pos : 0;
+	if ( tail + skip + rec - head > ringBytes ) {
+		ctl->overflowDrops++;
+		return 0;
+	}
+	if ( skip > 0 ) {
+		*(int *)(base + pos) = SHM_WRAP;
+		tail += skip;
+		pos = 0;
+	}
+	*(int *)(base + pos) = dst;
+	*(int *)(base + pos + 4) = size;
+	memcpy(base + pos + SHM_REC_HDR, data, size);
+	r->tail.store(tail + rec, memory_order_release);
+
+	if ( time < ticks ) {
+		sentCounts[(long)src * ticks + time]++;
+	}
+	ctl->totalSent++;
+	ctl->totalBytes += size;
+	return size;
+}
+
+/**
+ * FUNCTION NAME: drainRings
+ *
+ * DESCRIPTION: Move every message addressed to this worker out of the rings
+ * 				and into the inboxes of its nodes, worker by worker
+ */
+void ShmNet::drainRings() {
+	for ( int from = 0; from < workers; from++ ) {
+		shm_ring *r = ring(from, self);
+		char *base = (char *)(r + 1);
+		long head = r->head.load(memory_order_relaxed);
+		long tail = r->tail.load(memory_order_acquire);
+		while ( head < tail ) {
+			long pos = head % ringBytes;
+			int dst = *(int *)(base + pos);
+			if ( dst == SHM_WRAP ) {
+				head += ringBytes - pos;
+				continue;
+			}
+			int size = *(int *)(base + pos + 4);
+			char *buf = (char *)pool.alloc(size);
+			memcpy(buf, base + pos + SHM_REC_HDR, size);
+			inbox[dst].push_back(make_pair(buf, size));
+			head += (SHM_REC_HDR + size + SHM_ALIGN - 1) & ~(long)(SHM_ALIGN - 1);
+		}
+		r->head.store(head, memory_order_release);
+	}
+}
+
+/**
+ * FUNCTION NAME: ENrecv
+ *
+ * DESCRIPTION: Hand the node the messages drained for it. The rings are
+ * 				drained on the first call of each time unit.
+ *
+ * RETURN:
+ * 0
+ */
+int ShmNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue) {
+	int id = myaddr->getId();
+	int time = par->getcurrtime();
+
+	if ( lastDrain != time ) {
+		drainRings();
+		lastDrain = time;
+	}
+	for ( pair<char *, int> &msg : inbox[id] ) {
+		(*enq)(queue, msg.first, msg.second);
+		if ( time < ticks ) {
+			recvCounts[(long)id * ticks + time]++;
+		}
+	}
+	ctl->totalRecv += inbox[id].size();
+	inbox[id].clear();
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: ENrelease
+ *
+ * DESCRIPTION: Return a buffer received through ENrecv to the pool
+ */
+void ShmNet::ENrelease(char *data) {
+	pool.release(data);
+}
+
+/**
+ * FUNCTION NAME: ENmaxPayload
+ *
+ * DESCRIPTION: Largest message ENsend accepts under MAX_MSG_SIZE
+ */
+int ShmNet::ENmaxPayload() {
+	return par->MAX_MSG_SIZE - SHM_REC_HDR - 1;
+}
+
+/**
+ * FUNCTION NAME: ENsync
+ *
+ * DESCRIPTION: Barrier across the worker processes. The last worker to arrive
+ * 				resets the count and releases the others by bumping the generation.
+ */
+void ShmNet::ENsync() {
+	if ( self < 0 || workers == 1 ) {
+		return;
+	}
+	int gen = ctl->barrierGen.load(memory_order_acquire);
+	if ( ctl->barrierCount.fetch_add(1, memory_order_acq_rel) == workers - 1 ) {
+		ctl->barrierCount.store(0, memory_order_relaxed);
+		ctl->barrierGen.fetch_add(1, memory_order_release);
+		return;
+	}
+	while ( ctl->barrierGen.load(memory_order_acquire) == gen ) {
+		this_thread::yield();
+	}
+}
+
+/**
+ * FUNCTION NAME: spawn
+ *
+ * DESCRIPTION: Fork the worker processes. Returns the worker index in each
+ * 				worker and -1 in the parent.
+ */
+int ShmNet::spawn() {
+	for ( int w = 0; w < workers; w++ ) {
+		pid_t pid = fork();
+		if ( pid == 0 ) {
+			self = w;
+			return w;
+		}
+		if ( pid < 0 ) {
+			perror("ShmNet fork");
+			workerStats[w].status = FAILURE;
+			continue;
+		}
+		children.push_back(pid);
+	}
+	return -1;
+}
+
+/**
+ * FUNCTION NAME: noteTick
+ *
+ * DESCRIPTION: Record how long this worker spent on the current time unit and
+ * 				whether all of its live nodes had full membership at its end
+ */
+void ShmNet::noteTick(double seconds, bool fullMembership) {
+	long ns = (long)(seconds * 1e9);
+	long seen = ctl->maxTickNs.load(memory_order_relaxed);
+	while ( ns > seen && !ctl->maxTickNs.compare_exchange_weak(seen, ns, memory_order_relaxed) ) {
+	}
+	int time = par->getcurrtime();
+	if ( time < ticks ) {
+		fullFlags[(long)self * ticks + time] = fullMembership;
+	}
+}
+
+/**
+ * FUNCTION NAME: finishWorker
+ *
+ * DESCRIPTION: Report this worker's resource usage and end the process
+ */
+void ShmNet::finishWorker(int status) {
+	struct rusage usage;
+	shm_worker *stats = &workerStats[self];
+	getrusage(RUSAGE_SELF, &usage);
+	stats->nodes = 0;
+	for ( int id = 1; id < nextid; id++ ) {
+		stats->nodes += (ownerOf(id) == self);
+	}
+	stats->peakRssKb = usage.ru_maxrss;
+	stats->cpuSeconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+	stats->status = status;
+	fflush(stdout);
+	_exit(status == SUCCESS ? 0 : 1);
+}
+
+/**
+ * FUNCTION NAME: waitWorkers
+ *
+ * DESCRIPTION: Wait for every worker to exit. Returns false if any failed.
+ */
+bool ShmNet::waitWorkers() {
+	bool ok = true;
+	for ( pid_t pid : children ) {
+		int status;
+		if ( waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ) {
+			ok = false;
+		}
+	}
+	children.clear();
+	return ok;
+}
+
+/**
+ * FUNCTION NAME: getMaxTick
+ *
+ * DESCRIPTION: Slowest time unit seen by any worker, in seconds
+ */
+double ShmNet::getMaxTick() {
+	return ctl->maxTickNs.load() / 1e9;
+}
+
+/**
+ * FUNCTION NAME: firstFullTime
+ *
+ * DESCRIPTION: First time at which every worker reported full membership, -1 if never
+ */
+int ShmNet::firstFullTime() {
+	for ( int time = 0; time < ticks; time++ ) {
+		bool all = true;
+		for ( int w = 0; w < workers && all; w++ ) {
+			all = fullFlags[(long)w * ticks + time];
+		}
+		if ( all ) {
+			return time;
+		}
+	}
+	return -1;
+}
+
+/**
+ * FUNCTION NAME: getWorkerStats
+ *
+ * DESCRIPTION: Resource usage reported by worker w
+ */
+shm_worker *ShmNet::getWorkerStats(int w) {
+	return &workerStats[w];
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Copy the shared message counts and write msgcount.log.
+ * 				Called once, by the parent, after the workers have exited.
+ */
+int ShmNet::ENcleanup() {
+	int n = min(nextid, par->EN_GPSZ + 1);
+	sent_msgs.assign(n, vector<int>());
+	recv_msgs.assign(n, vector<int>());
+	for ( int id = 1; id < n; id++ ) {
+		sent_msgs[id].assign(sentCounts + (long)id * ticks, sentCounts + (long)(id + 1) * ticks);
+		recv_msgs[id].assign(recvCounts + (long)id * ticks, recvCounts + (long)(id + 1) * ticks);
+	}
+	writeMsgCount(par);
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: getTotalSent
+ *
+ * DESCRIPTION: Number of messages written to the rings by all workers
+ */
+long ShmNet::getTotalSent() {
+	return ctl->totalSent;
+}
+
+/**
+ * FUNCTION NAME: getTotalRecv
+ *
+ * DESCRIPTION: Number of messages handed out by ENrecv in all workers
+ */
+long ShmNet::getTotalRecv() {
+	return ctl->totalRecv;
+}
+
+/**
+ * FUNCTION NAME: getTotalBytes
+ *
+ * DESCRIPTION: Payload bytes written to the rings by all workers
+ */
+long ShmNet::getTotalBytes() {
+	return ctl->totalBytes;
+}
+
+/**
+ * FUNCTION NAME: getOverflowDrops
+ *
+ * DESCRIPTION: Number of messages refused because their ring was full
+ */
+long ShmNet::getOverflowDrops() {
+	return ctl->overflowDrops;
+}
+
+/**
+ * FUNCTION NAME: getOversizeDrops
+ *
+ * DESCRIPTION: Number of messages refused because they exceed MAX_MSG_SIZE
+ */
+long ShmNet::getOversizeDrops() {
+	return ctl->oversizeDrops;
+}
@@ -0,0 +1,138 @@
+/**********************************
+ * FILE NAME: ShmNet.h
+ *
+ * DESCRIPTION: Shared-memory multi-process transport header file
+ **********************************/
+
+#ifndef _SHMNET_H_
+#define _SHMNET_H_
+
+#include "stdincludes.h"
+#include "Params.h"
+#include "Member.h"
+#include "BufferPool.h"
+#include "Transport.h"
+
+/*
+ * Macros
+ */
+// bytes in front of every payload in a ring: destination id and size
+#define SHM_REC_HDR 8
+// records are padded to this many bytes
+#define SHM_ALIGN 8
+// destination id marking the unused tail of a ring before it wraps
+#define SHM_WRAP -1
+
+/**
+ * STRUCT NAME: shm_ring
+ *
+ * DESCRIPTION: Single-producer, single-consumer byte ring between two worker
+ * 				processes, followed in memory by its data. head and tail count
+ * 				bytes ever consumed and produced; each sits on its own cache line.
+ */
+typedef struct shm_ring {
+	atomic<long> head;
+	char pad1[64 - sizeof(atomic<long>)];
+	atomic<long> tail;
+	char pad2[64 - sizeof(atomic<long>)];
+}shm_ring;
+
+/**
+ * STRUCT NAME: shm_worker
+ *
+ * DESCRIPTION: Resource usage a worker process reports before it exits
+ */
+typedef struct shm_worker {
+	int nodes;
+	long peakRssKb;
+	double cpuSeconds;
+	int status;
+}shm_worker;
+
+/**
+ * STRUCT NAME: shm_control
+ *
+ * DESCRIPTION: Counters and barrier shared by all worker processes
+ */
+typedef struct shm_control {
+	atomic<int> barrierCount;
+	atomic<int> barrierGen;
+	atomic<long> totalSent;
+	atomic<long> totalRecv;
+	atomic<long> totalBytes;
+	atomic<long> overflowDrops;
+	atomic<long> oversizeDrops;
+	// slowest time unit seen by any worker, in nanoseconds
+	atomic<long> maxTickNs;
+}shm_control;
+
+/**
+ * CLASS NAME: ShmNet
+ *
+ * DESCRIPTION: Transport for running the nodes in PROCESSES forked worker
+ * 				processes; worker w owns node index i (id i + 1) when
+ * 				i % PROCESSES == w. Every ordered pair
+ * 				of workers shares an mmap'd single-producer, single-consumer ring
+ * 				of SHM_RING_KB kilobytes. A worker drains the rings addressed to
+ * 				it once per time unit into per-node inboxes. Random drops follow
+ * 				DROP_MSG as in EmulNet; a message that does not fit its ring is
+ * 				counted as an overflow drop. Message counts per node and time live
+ * 				in the shared segment so the parent can write msgcount.log.
+ * 				The workers step in lockstep through a shared-memory barrier.
+ */
+class ShmNet: public Transport {
+private:
+	Params *par;
+	int nextid;
+	int workers;
+	// index of this worker process, -1 in the parent
+	int self;
+	int ticks;
+	char *segment;
+	size_t segmentSize;
+	shm_control *ctl;
+	shm_worker *workerStats;
+	// per worker and time: 1 if all of the worker's live nodes had full membership
+	char *fullFlags;
+	// message counts indexed by node id * ticks + time
+	int *sentCounts;
+	int *recvCounts;
+	char *rings;
+	long ringBytes;
+	vector<pid_t> children;
+	vector<minstd_rand> dropRng;
+	BufferPool pool;
+	// messages drained from the rings, per destination node id
+	vector< vector< pair<char *, int> > > inbox;
+	int lastDrain;
+	ShmNet(const ShmNet &anotherShmNet);
+	ShmNet& operator =(const ShmNet &anotherShmNet);
+	shm_ring *ring(int from, int to);
+	int ownerOf(int id);
+	void drainRings();
+public:
+	ShmNet(Params *p);
+	virtual ~ShmNet();
+	void *ENinit(Address *myaddr, short port);
+	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
+	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
+	void ENrelease(char *data);
+	int ENmaxPayload();
+	void ENsync();
+	int ENcleanup();
+	long getTotalSent();
+	long getTotalRecv();
+	long getTotalBytes();
+	long getOverflowDrops();
+	long getOversizeDrops();
+	int getWorkers();
+	int spawn();
+	void noteTick(double seconds, bool fullMembership);
+	void finishWorker(int status);
+	bool waitWorkers();
+	double getMaxTick();
+	int firstFullTime();
+	shm_worker *getWorkerStats(int w);
+};
+
+#endif /* _SHMNET_H_ */
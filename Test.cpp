@@ -0,0 +1,147 @@
+/**********************************
+ * FILE NAME: Test.cpp
+ *
+ * DESCRIPTION: Protocol tests. Built and run by "make test". Each test steps
+ * 				a few MP1Nodes by hand over an EmulNet and prints ok or FAILED;
+ * 				the exit status is non-zero if any test failed.
+ **********************************/
+
+#include "stdincludes.h"
+#include "Params.h"
+#include "Member.h"
+#include "EmulNet.h"
+#include "Log.h"
+#include "Queue.h"
+#include "MP1Node.h"
+
+static int failures = 0;
+
+/**
+ * FUNCTION NAME: check
+ *
+ * DESCRIPTION: Report the outcome of one test
+ */
+static void check(const char *name, bool ok) {
+	printf("%-40s %s\n", name, ok ? "ok" : "FAILED");
+	if ( !ok ) {
+		failures++;
+	}
+}
+
+/**
+ * CLASS NAME: TestWorld
+ *
+ * DESCRIPTION: An EmulNet holding groupSize SWIM nodes, ids 1 .. groupSize,
+ * 				each of which knows all the others at incarnation 0
+ */
+class TestWorld {
+public:
+	Params par;
+	EmulNet *en;
+	Log *log;
+	vector<Address> addrs;
+	vector<Member *> members;
+	vector<MP1Node *> nodes;
+	TestWorld(int groupSize);
+	virtual ~TestWorld();
+	void deliver(int id);
+	MemberListEntry *entry(int id, int about);
+};
+
+/**
+ * Constructor
+ */
+TestWorld::TestWorld(int groupSize) {
+	par.setdefaults();
+	par.MAX_NNB = groupSize;
+	par.EN_GPSZ = groupSize;
+	par.SWIM = 1;
+	par.QUIET_LOG = 1;
+	par.globaltime = 1;
+	en = new EmulNet(&par);
+	log = new Log(&par);
+	// addrs[i], members[i] and nodes[i] are node id i; id 0 is unused
+	addrs.resize(groupSize + 1);
+	members.resize(groupSize + 1);
+	nodes.resize(groupSize + 1);
+	for ( int i = 1; i <= groupSize; i++ ) {
+		en->ENinit(&addrs[i], par.PORTNUM);
+		members[i] = new Member;
+		nodes[i] = new MP1Node(members[i], &par, en, log, &addrs[i]);
+		nodes[i]->initThisNode(&addrs[i]);
+		members[i]->inGroup = true;
+	}
+	for ( int i = 1; i <= groupSize; i++ ) {
+		for ( int j = 1; j <= groupSize; j++ ) {
+			if ( i != j ) {
+				nodes[i]->addMember(&addrs[j], 0, 0, false);
+			}
+		}
+	}
+}
+
+/**
+ * Destructor
+ */
+TestWorld::~TestWorld() {
+	for ( int i = 1; i < (int)nodes.size(); i++ ) {
+		nodes[i]->recvLoop();
+		while ( !members[i]->mp1q.empty() ) {
+			en->ENrelease((char *)members[i]->mp1q.front().elt);
+			members[i]->mp1q.pop();
+		}
+		delete nodes[i];
+		delete members[i];
+	}
+	delete log;
+	delete en;
+}
+
+/**
+ * FUNCTION NAME: deliver
+ *
+ * DESCRIPTION: Have node id handle every message waiting for it
+ */
+void TestWorld::deliver(int id) {
+	nodes[id]->recvLoop();
+	nodes[id]->checkMessages();
+}
+
+/**
+ * FUNCTION NAME: entry
+ *
+ * DESCRIPTION: What node id knows of node about, null if it is not listed
+ */
+MemberListEntry *TestWorld::entry(int id, int about) {
+	return nodes[id]->getMemberIfPresent(addrs[about].getId(), addrs[about].getPort());
+}
+
+/**
+ * FUNCTION NAME: testRefutationSpreads
+ *
+ * DESCRIPTION: Node 3 suspects node 2. Node 2 refutes and tells only node 1,
+ * 				which must pass the refutation on to node 3.
+ */
+static void testRefutationSpreads() {
+	TestWorld w(3);
+	MemberListEntry *suspected = w.entry(3, 2);
+	w.nodes[3]->suspect(suspected, 0);
+	MemberListEntry report = *suspected;
+	w.nodes[2]->refute(&report);
+	w.nodes[2]->sendSwim(&w.addrs[1], PING, nullptr);
+	w.deliver(1);
+	w.nodes[1]->sendSwim(&w.addrs[3], PING, nullptr);
+	w.deliver(3);
+	MemberListEntry *e = w.entry(3, 2);
+	check("refutation reaches a third node", e != nullptr && e->state == MEMBER_ALIVE && e->incarnation == 1);
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Run every test
+ **********************************/
+int main(int argc, char *argv[]) {
+	testRefutationSpreads();
+	return failures == 0 ? SUCCESS : FAILURE;
+}
@@ -0,0 +1,141 @@
+/**********************************
+ * FILE NAME: ThreadPool.cpp
+ *
+ * DESCRIPTION: Definition of ThreadPool class
+ **********************************/
+
+#include "ThreadPool.h"
+
+thread_local int ThreadPool::workerIndex = 0;
+
+/**
+ * Constructor
+ *
+ * Starts numWorkers - 1 helper threads; the caller of parallelFor is worker 0.
+ */
+ThreadPool::ThreadPool(int numWorkers): numWorkers(max(1, numWorkers)), generation(0), active(0), stopping(false) {
+	ranges = new work_range[this->numWorkers];
+	for ( int w = 1; w < this->numWorkers; w++ ) {
+		threads.push_back(thread(&ThreadPool::workerLoop, this, w));
+	}
+}
+
+/**
+ * Destructor
+ */
+ThreadPool::~ThreadPool() {
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for ( thread &t : threads ) {
+		t.join();
+	}
+	delete[] ranges;
+}
+
+/**
+ * FUNCTION NAME: getNumWorkers
+ *
+ * DESCRIPTION: Number of workers, including the calling thread
+ */
+int ThreadPool::getNumWorkers() {
+	return numWorkers;
+}
+
+/**
+ * FUNCTION NAME: currentWorker
+ *
+ * DESCRIPTION: Index of the worker running the calling thread, 0 outside the pool
+ */
+int ThreadPool::currentWorker() {
+	return workerIndex;
+}
+
+/**
+ * FUNCTION NAME: take
+ *
+ * DESCRIPTION: Claim the next THREADPOOL_GRAIN indices of worker w's share.
+ * 				Returns false if the share is used up.
+ */
+bool ThreadPool::take(int w, int *begin, int *end) {
+	work_range *r = &ranges[w];
+	int i = r->next.fetch_add(THREADPOOL_GRAIN, memory_order_relaxed);
+	if ( i >= r->end ) {
+		return false;
+	}
+	*begin = i;
+	*end = min(i + THREADPOOL_GRAIN, r->end);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: runShare
+ *
+ * DESCRIPTION: Run worker w's share, then steal from the other workers until
+ * 				every share is used up
+ */
+void ThreadPool::runShare(int w) {
+	int begin, end;
+	for ( int k = 0; k < numWorkers; k++ ) {
+		int victim = (w + k) % numWorkers;
+		while ( take(victim, &begin, &end) ) {
+			for ( int i = begin; i < end; i++ ) {
+				body(i);
+			}
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: workerLoop
+ *
+ * DESCRIPTION: Helper thread. Runs its share of every parallelFor until the pool is destroyed.
+ */
+void ThreadPool::workerLoop(int w) {
+	unsigned long seen = 0;
+	workerIndex = w;
+	while ( true ) {
+		{
+			unique_lock<mutex> guard(lock);
+			wake.wait(guard, [&]() { return stopping || generation != seen; });
+			if ( stopping ) {
+				return;
+			}
+			seen = generation;
+		}
+		runShare(w);
+		{
+			unique_lock<mutex> guard(lock);
+			if ( --active == 0 ) {
+				done.notify_one();
+			}
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: parallelFor
+ *
+ * DESCRIPTION: Call body(i) for every i in [begin, end) across the workers and
+ * 				return once all calls have finished. Calls for different indices
+ * 				may run concurrently and in any order.
+ */
+void ThreadPool::parallelFor(int begin, int end, function<void(int)> body) {
+	int n = max(0, end - begin);
+	this->body = body;
+	for ( int w = 0; w < numWorkers; w++ ) {
+		ranges[w].next.store(begin + (int)((long)n * w / numWorkers), memory_order_relaxed);
+		ranges[w].end = begin + (int)((long)n * (w + 1) / numWorkers);
+	}
+	{
+		unique_lock<mutex> guard(lock);
+		active = numWorkers - 1;
+		generation++;
+	}
+	wake.notify_all();
+	runShare(0);
+	unique_lock<mutex> guard(lock);
+	done.wait(guard, [&]() { return active == 0; });
+}
@@ -0,0 +1,70 @@
+/**********************************
+ * FILE NAME: ThreadPool.h
+ *
+ * DESCRIPTION: Header file of ThreadPool class
+ **********************************/
+
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// indices taken from a range at a time
+#define THREADPOOL_GRAIN 8
+
+/**
+ * STRUCT NAME: work_range
+ *
+ * DESCRIPTION: The share of a parallelFor given to one worker. The owner and
+ * 				any thief advance next with fetch_add, so every index in
+ * 				[next, end) is handed out exactly once.
+ */
+typedef struct work_range {
+	atomic<int> next;
+	int end;
+	// keep each range on its own cache line
+	char pad[64 - sizeof(atomic<int>) - sizeof(int)];
+}work_range;
+
+/**
+ * CLASS NAME: ThreadPool
+ *
+ * DESCRIPTION: Fixed set of worker threads running parallel loops.
+ * 				parallelFor splits the index range into one contiguous share per
+ * 				worker; a worker that finishes its share steals from the others.
+ * 				The calling thread takes part as worker 0 and parallelFor returns
+ * 				only when every index is done, so consecutive calls are separated
+ * 				by a barrier.
+ */
+class ThreadPool {
+private:
+	int numWorkers;
+	vector<thread> threads;
+	work_range *ranges;
+	function<void(int)> body;
+	mutex lock;
+	condition_variable wake;
+	condition_variable done;
+	// bumped for every parallelFor, workers wait for it to change
+	unsigned long generation;
+	// helper threads still working on the current parallelFor
+	int active;
+	bool stopping;
+	static thread_local int workerIndex;
+	ThreadPool(const ThreadPool &anotherPool);
+	ThreadPool& operator =(const ThreadPool &anotherPool);
+	bool take(int w, int *begin, int *end);
+	void runShare(int w);
+	void workerLoop(int w);
+public:
+	ThreadPool(int numWorkers);
+	virtual ~ThreadPool();
+	void parallelFor(int begin, int end, function<void(int)> body);
+	int getNumWorkers();
+	static int currentWorker();
+};
+
+#endif /* _THREADPOOL_H_ */
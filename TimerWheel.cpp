@@ -0,0 +1,179 @@
+/**********************************
+ * FILE NAME: TimerWheel.cpp
+ *
+ * DESCRIPTION: Definition of TimerWheel class
+ **********************************/
+
+#include "TimerWheel.h"
+
+/**
+ * Constructor
+ */
+TimerWheel::TimerWheel(long horizon): mask(0), now(0), armed(0) {
+	reset(horizon, 0);
+}
+
+/**
+ * FUNCTION NAME: reset
+ *
+ * DESCRIPTION: Disarm every timer, set the clock to time and size the wheel for
+ * 				deadlines up to horizon time units ahead
+ */
+void TimerWheel::reset(long horizon, long time) {
+	long slots = 1;
+	while ( slots <= horizon ) {
+		slots <<= 1;
+	}
+	heads.assign(slots, -1);
+	mask = slots - 1;
+	nodes.clear();
+	now = time;
+	armed = 0;
+}
+
+/**
+ * FUNCTION NAME: link
+ *
+ * DESCRIPTION: File the timer of id under time due, at the head of its wheel slot
+ */
+void TimerWheel::link(int id, long due) {
+	timer_node &t = nodes[id];
+	int slot = due & mask;
+	t.due = due;
+	t.slot = slot;
+	t.prev = -1;
+	t.next = heads[slot];
+	if ( heads[slot] >= 0 ) {
+		nodes[heads[slot]].prev = id;
+	}
+	heads[slot] = id;
+	armed++;
+}
+
+/**
+ * FUNCTION NAME: unlink
+ *
+ * DESCRIPTION: Take the timer of id out of its wheel slot
+ */
+void TimerWheel::unlink(int id) {
+	timer_node &t = nodes[id];
+	if ( t.prev >= 0 ) {
+		nodes[t.prev].next = t.next;
+	}
+	else {
+		heads[t.slot] = t.next;
+	}
+	if ( t.next >= 0 ) {
+		nodes[t.next].prev = t.prev;
+	}
+	t.slot = -1;
+	armed--;
+}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Arm the timer of id for deadline, replacing any deadline it had.
+ * 				A later deadline is only recorded; an earlier one refiles the
+ * 				timer. A deadline already past fires on the next advance.
+ */
+void TimerWheel::schedule(int id, long deadline) {
+	if ( id >= (int)nodes.size() ) {
+		timer_node unused = {0, 0, -1, -1, -1};
+		nodes.resize(id + 1, unused);
+	}
+	timer_node &t = nodes[id];
+	if ( t.slot >= 0 ) {
+		if ( deadline >= t.due ) {
+			t.deadline = deadline;
+			return;
+		}
+		unlink(id);
+	}
+	t.deadline = deadline;
+	link(id, max(deadline, now + 1));
+}
+
+/**
+ * FUNCTION NAME: cancel
+ *
+ * DESCRIPTION: Disarm the timer of id, if armed
+ */
+void TimerWheel::cancel(int id) {
+	if ( id < (int)nodes.size() && nodes[id].slot >= 0 ) {
+		unlink(id);
+	}
+}
+
+/**
+ * FUNCTION NAME: advance
+ *
+ * DESCRIPTION: Move the clock to time and append the ids whose deadline has come
+ * 				to expired, disarming them. Timers whose deadline was postponed
+ * 				are refiled under it. A jump of a whole turn or more walks every
+ * 				wheel slot once.
+ */
+void TimerWheel::advance(long time, vector<int> &expired) {
+	if ( time <= now ) {
+		return;
+	}
+	long from = max(now + 1, time - mask);
+	now = time;
+	for ( long t = from; t <= time; t++ ) {
+		int id = heads[t & mask];
+		while ( id >= 0 ) {
+			int next = nodes[id].next;
+			if ( nodes[id].deadline <= time ) {
+				unlink(id);
+				expired.push_back(id);
+			}
+			else if ( nodes[id].due <= time ) {
+				unlink(id);
+				link(id, nodes[id].deadline);
+			}
+			id = next;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: nextDue
+ *
+ * DESCRIPTION: Earliest time a timer is filed under, -1 if none is armed. The
+ * 				next advance past that time expires or refiles it.
+ */
+long TimerWheel::nextDue() {
+	long best = -1;
+	if ( armed == 0 ) {
+		return best;
+	}
+	for ( long t = now + 1; t <= now + mask + 1; t++ ) {
+		for ( int id = heads[t & mask]; id >= 0; id = nodes[id].next ) {
+			if ( nodes[id].due == t ) {
+				return t;
+			}
+			if ( best < 0 || nodes[id].due < best ) {
+				best = nodes[id].due;
+			}
+		}
+	}
+	return best;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Number of armed timers
+ */
+int TimerWheel::size() {
+	return armed;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Disarm every timer, keeping the wheel size and clock
+ */
+void TimerWheel::clear() {
+	reset(mask, now);
+}
@@ -0,0 +1,64 @@
+/**********************************
+ * FILE NAME: TimerWheel.h
+ *
+ * DESCRIPTION: Header file of TimerWheel class
+ **********************************/
+
+#ifndef _TIMERWHEEL_H_
+#define _TIMERWHEEL_H_
+
+#include "stdincludes.h"
+
+/**
+ * STRUCT NAME: timer_node
+ *
+ * DESCRIPTION: Timer of one id, linked into the list of its wheel slot
+ */
+typedef struct timer_node {
+	long deadline;
+	// time of the wheel slot the timer is filed under, at most deadline
+	long due;
+	// wheel slot the timer is linked into, -1 while disarmed
+	int slot;
+	int prev;
+	int next;
+}timer_node;
+
+/**
+ * CLASS NAME: TimerWheel
+ *
+ * DESCRIPTION: Hashed timer wheel holding at most one deadline per small integer
+ * 				id, such as a MemberTable slot. A deadline lands in wheel slot
+ * 				deadline % number of slots, so arming, re-arming and disarming
+ * 				are O(1) and advancing the clock only walks the slots of the
+ * 				elapsed times. Postponing a deadline only records it: the timer
+ * 				stays filed under its earlier time and is refiled when that time
+ * 				comes, so a deadline pushed back on every heartbeat costs one
+ * 				refiling per timeout period rather than one per heartbeat.
+ * 				Sizing the wheel to the longest timeout in use keeps deadlines
+ * 				within one turn.
+ */
+class TimerWheel {
+private:
+	// timer of each id, indexed by id
+	vector<timer_node> nodes;
+	// first timer of each wheel slot, -1 if empty; size is a power of two
+	vector<int> heads;
+	long mask;
+	// last time advance() walked
+	long now;
+	int armed;
+	void link(int id, long due);
+	void unlink(int id);
+public:
+	TimerWheel(long horizon = 64);
+	void reset(long horizon, long time);
+	void schedule(int id, long deadline);
+	void cancel(int id);
+	void advance(long time, vector<int> &expired);
+	long nextDue();
+	int size();
+	void clear();
+};
+
+#endif /* _TIMERWHEEL_H_ */
@@ -0,0 +1,150 @@
+/**********************************
+ * FILE NAME: Transport.cpp
+ *
+ * DESCRIPTION: Default Transport operations and the backend factory
+ **********************************/
+
+#include "Transport.h"
+#include "EmulNet.h"
+#include "UdpNet.h"
+#include "ShmNet.h"
+
+/**
+ * FUNCTION NAME: ENsendBatch
+ *
+ * DESCRIPTION: Send the same message to count destinations.
+ * 				Backends that can batch the sends override this.
+ *
+ * RETURNS:
+ * number of destinations the message was accepted for
+ */
+int Transport::ENsendBatch(Address *myaddr, Address *toaddrs, int count, char *data, int size) {
+	int accepted = 0;
+	for ( int i = 0; i < count; i++ ) {
+		if ( ENsend(myaddr, &toaddrs[i], data, size) > 0 ) {
+			accepted++;
+		}
+	}
+	return accepted;
+}
+
+/**
+ * FUNCTION NAME: ENsetStaging
+ *
+ * DESCRIPTION: Hold sends per sender until ENflushStaged, so nodes can be stepped
+ * 				concurrently with a deterministic outcome. Backends that do not
+ * 				stage send at once.
+ */
+void Transport::ENsetStaging(bool on) {}
+
+/**
+ * FUNCTION NAME: ENflushStaged
+ *
+ * DESCRIPTION: Deliver the sends staged by one node
+ */
+void Transport::ENflushStaged(Address *myaddr) {}
+
+/**
+ * FUNCTION NAME: ENsync
+ *
+ * DESCRIPTION: Called between the receive pass and the nodeLoop pass and at the
+ * 				end of every time unit. Backends whose nodes run in several
+ * 				processes wait here for the others.
+ */
+void Transport::ENsync() {}
+
+/**
+ * FUNCTION NAME: getSyscalls
+ *
+ * DESCRIPTION: Number of system calls made to move messages, 0 for in-process backends
+ */
+long Transport::getSyscalls() {
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: countMsg
+ *
+ * DESCRIPTION: Count one message for node at time, growing the counters as needed
+ */
+void Transport::countMsg(vector< vector<int> > &counts, int node, int time) {
+	if ( node >= (int)counts.size() ) {
+		counts.resize(node + 1);
+	}
+	vector<int> &row = counts[node];
+	if ( time >= (int)row.size() ) {
+		row.resize(time + 1, 0);
+	}
+	row[time]++;
+}
+
+/**
+ * FUNCTION NAME: getCount
+ *
+ * DESCRIPTION: Number of messages counted for node at time
+ */
+int Transport::getCount(vector< vector<int> > &counts, int node, int time) {
+	if ( node >= (int)counts.size() || time >= (int)counts[node].size() ) {
+		return 0;
+	}
+	return counts[node][time];
+}
+
+/**
+ * FUNCTION NAME: writeMsgCount
+ *
+ * DESCRIPTION: Write the per-node, per-time message counts to msgcount.log
+ */
+void Transport::writeMsgCount(Params *par) {
+	int i, j;
+	int sent_total, recv_total;
+	int sent, recv;
+
+	FILE* file = fopen("msgcount.log", "w+");
+
+	for ( i = 1; i <= par->EN_GPSZ; i++ ) {
+		fprintf(file, "node %3d ", i);
+		sent_total = 0;
+		recv_total = 0;
+
+		for (j = 0; j < par->getcurrtime(); j++) {
+
+			sent = getCount(sent_msgs, i, j);
+			recv = getCount(recv_msgs, i, j);
+			sent_total += sent;
+			recv_total += recv;
+			if (i != 67) {
+				fprintf(file, " (%4d, %4d)", sent, recv);
+				if (j % 10 == 9) {
+					fprintf(file, "\n         ");
+				}
+			}
+			else {
+				fprintf(file, "special %4d %4d %4d\n", j, sent, recv);
+			}
+		}
+		fprintf(file, "\n");
+		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n\n", i, sent_total, recv_total);
+	}
+
+	fclose(file);
+}
+
+/**
+ * FUNCTION NAME: create
+ *
+ * DESCRIPTION: Build the backend named by par->TRANSPORT
+ */
+Transport *Transport::create(Params *par) {
+	switch ( par->TRANSPORT ) {
+		case EMULNET_TRANSPORT:
+			return new EmulNet(par);
+		case UDP_TRANSPORT:
+			return new UdpNet(par);
+		case SHM_TRANSPORT:
+			return new ShmNet(par);
+		default:
+			cout << "Unknown TRANSPORT " << par->TRANSPORT << ", using EmulNet" << endl;
+			return new EmulNet(par);
+	}
+}
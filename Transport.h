@@ -0,0 +1,62 @@
+/**********************************
+ * FILE NAME: Transport.h
+ *
+ * DESCRIPTION: Header file of the Transport interface
+ **********************************/
+
+#ifndef _TRANSPORT_H_
+#define _TRANSPORT_H_
+
+#include "stdincludes.h"
+#include "Params.h"
+#include "Member.h"
+
+/*
+ * Backends selected by the TRANSPORT config key
+ */
+enum TransportTypes {
+	EMULNET_TRANSPORT,
+	UDP_TRANSPORT,
+	SHM_TRANSPORT
+};
+
+/**
+ * CLASS NAME: Transport
+ *
+ * DESCRIPTION: Network interface the membership protocol is written against.
+ * 				A backend assigns node addresses, carries messages between them
+ * 				and counts its traffic. Received buffers belong to the backend
+ * 				and are handed to the receiver, which gives them back with
+ * 				ENrelease once the message is handled.
+ */
+class Transport {
+protected:
+	// per-node message counts, indexed by node id and then by time; each
+	// row grows only as far as the last time that node sent or received
+	vector< vector<int> > sent_msgs;
+	vector< vector<int> > recv_msgs;
+	static void countMsg(vector< vector<int> > &counts, int node, int time);
+	static int getCount(vector< vector<int> > &counts, int node, int time);
+	void writeMsgCount(Params *par);
+public:
+	virtual ~Transport() {}
+	virtual void *ENinit(Address *myaddr, short port) = 0;
+	virtual int ENsend(Address *myaddr, Address *toaddr, char *data, int size) = 0;
+	virtual int ENsendBatch(Address *myaddr, Address *toaddrs, int count, char *data, int size);
+	virtual int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue) = 0;
+	virtual void ENrelease(char *data) = 0;
+	virtual int ENmaxPayload() = 0;
+	virtual void ENsetStaging(bool on);
+	virtual void ENflushStaged(Address *myaddr);
+	virtual void ENsync();
+	virtual int ENcleanup() = 0;
+	virtual long getTotalSent() = 0;
+	virtual long getTotalRecv() = 0;
+	virtual long getTotalBytes() = 0;
+	virtual long getOverflowDrops() = 0;
+	virtual long getOversizeDrops() = 0;
+	virtual long getSyscalls();
+	static Transport *create(Params *par);
+};
+
+#endif /* _TRANSPORT_H_ */
@@ -0,0 +1,362 @@
+/**********************************
+ * FILE NAME: UdpNet.cpp
+ *
+ * DESCRIPTION: Loopback UDP transport definition
+ **********************************/
+
+#include "UdpNet.h"
+
+/**
+ * Constructor
+ *
+ * Raises the open file limit as far as allowed, since every node needs a socket.
+ */
+UdpNet::UdpNet(Params *p): par(p), nextid(1), lastPoll(-1), totalSent(0), totalRecv(0), totalBytes(0), sendErrors(0), oversizeDrops(0), syscalls(0) {
+	struct rlimit limit;
+	if ( getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max ) {
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+	epfd = epoll_create1(0);
+	for ( int i = 0; i < UDP_BATCH; i++ ) {
+		spare[i] = (char *)pool.alloc(par->MAX_MSG_SIZE);
+	}
+}
+
+/**
+ * Destructor
+ */
+UdpNet::~UdpNet() {
+	ENcleanup();
+	for ( int i = 0; i < UDP_BATCH; i++ ) {
+		if ( spare[i] != NULL ) {
+			pool.release(spare[i]);
+			spare[i] = NULL;
+		}
+	}
+	if ( epfd >= 0 ) {
+		close(epfd);
+		epfd = -1;
+	}
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Give the node the next id and a socket on UDP_BASE_PORT + id
+ */
+void *UdpNet::ENinit(Address *myaddr, short port) {
+	int id = nextid++;
+	*myaddr = Address(id, 0);
+
+	int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if ( fd >= 0 ) {
+		int rcvbuf = UDP_RCVBUF;
+		struct sockaddr_in local;
+		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+		setDest(&local, myaddr);
+		if ( bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0 ) {
+			perror("UdpNet bind");
+			close(fd);
+			fd = -1;
+		}
+	}
+	else {
+		perror("UdpNet socket");
+	}
+	if ( fd >= 0 ) {
+		struct epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.u32 = id;
+		epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+	}
+
+	if ( id >= (int)sockets.size() ) {
+		sockets.resize(id + 1, -1);
+		ready.resize(id + 1, false);
+		sent_msgs.resize(id + 1);
+		recv_msgs.resize(id + 1);
+	}
+	sockets[id] = fd;
+	seed_seq seq{par->SEED, (unsigned int)id};
+	while ( id >= (int)dropRng.size() ) {
+		dropRng.push_back(minstd_rand());
+	}
+	dropRng[id].seed(seq);
+	events.resize(sockets.size());
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: setDest
+ *
+ * DESCRIPTION: Fill in the socket address of a node
+ */
+void UdpNet::setDest(struct sockaddr_in *dest, Address *toaddr) {
+	memset(dest, 0, sizeof(*dest));
+	dest->sin_family = AF_INET;
+	dest->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	dest->sin_port = htons(par->UDP_BASE_PORT + toaddr->getId());
+}
+
+/**
+ * FUNCTION NAME: accept
+ *
+ * DESCRIPTION: Decide whether one datagram of size bytes from myaddr goes out,
+ * 				counting oversize messages and applying random drops
+ */
+bool UdpNet::accept(Address *myaddr, int size) {
+	if ( size > ENmaxPayload() ) {
+		oversizeDrops++;
+		return false;
+	}
+	if ( par->dropmsg && (int)(dropRng[myaddr->getId()]() % 100) < (int)(par->MSG_DROP_PROB * 100) ) {
+		return false;
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: counted
+ *
+ * DESCRIPTION: Count one datagram of size bytes handed to the kernel by myaddr
+ */
+void UdpNet::counted(Address *myaddr, int size) {
+	countMsg(sent_msgs, myaddr->getId(), par->getcurrtime());
+	totalSent++;
+	totalBytes += size;
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Send one datagram with sendto
+ *
+ * RETURNS:
+ * size
+ */
+int UdpNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
+	struct sockaddr_in dest;
+	int fd = sockets[myaddr->getId()];
+
+	if ( fd < 0 || !accept(myaddr, size) ) {
+		return 0;
+	}
+	setDest(&dest, toaddr);
+	syscalls++;
+	if ( sendto(fd, data, size, 0, (struct sockaddr *)&dest, sizeof(dest)) < 0 ) {
+		sendErrors++;
+		return 0;
+	}
+	counted(myaddr, size);
+	return size;
+}
+
+/**
+ * FUNCTION NAME: ENsendBatch
+ *
+ * DESCRIPTION: Send the same datagram to count destinations with sendmmsg,
+ * 				UDP_BATCH destinations per call, all sharing one iovec
+ *
+ * RETURNS:
+ * number of destinations the datagram was sent to
+ */
+int UdpNet::ENsendBatch(Address *myaddr, Address *toaddrs, int count, char *data, int size) {
+	struct iovec iov;
+	int fd = sockets[myaddr->getId()];
+	int accepted = 0;
+
+	if ( fd < 0 ) {
+		return 0;
+	}
+	iov.iov_base = data;
+	iov.iov_len = size;
+
+	int i = 0;
+	while ( i < count ) {
+		// gather the next batch of destinations that survive the drop decision
+		int n = 0;
+		for ( ; i < count && n < UDP_BATCH; i++ ) {
+			if ( !accept(myaddr, size) ) {
+				continue;
+			}
+			setDest(&dests[n], &toaddrs[i]);
+			memset(&msgs[n], 0, sizeof(msgs[n]));
+			msgs[n].msg_hdr.msg_name = &dests[n];
+			msgs[n].msg_hdr.msg_namelen = sizeof(dests[n]);
+			msgs[n].msg_hdr.msg_iov = &iov;
+			msgs[n].msg_hdr.msg_iovlen = 1;
+			n++;
+		}
+		int done = 0;
+		while ( done < n ) {
+			syscalls++;
+			int sent = sendmmsg(fd, &msgs[done], n - done, 0);
+			if ( sent <= 0 ) {
+				// skip the datagram the kernel refused and carry on with the rest
+				sendErrors++;
+				done++;
+				continue;
+			}
+			for ( int k = 0; k < sent; k++ ) {
+				counted(myaddr, size);
+			}
+			accepted += sent;
+			done += sent;
+		}
+	}
+	return accepted;
+}
+
+/**
+ * FUNCTION NAME: pollReady
+ *
+ * DESCRIPTION: Ask epoll, without waiting, which sockets have datagrams pending
+ */
+void UdpNet::pollReady() {
+	int n;
+	do {
+		syscalls++;
+		n = epoll_wait(epfd, &events[0], events.size(), 0);
+		for ( int i = 0; i < n; i++ ) {
+			ready[events[i].data.u32] = true;
+		}
+	} while ( n == (int)events.size() );
+}
+
+/**
+ * FUNCTION NAME: ENrecv
+ *
+ * DESCRIPTION: Drain the node's socket with recvmmsg if epoll reported it readable.
+ * 				The datagrams are received straight into pool buffers, which are
+ * 				handed to enq and given back with ENrelease.
+ *
+ * RETURN:
+ * 0
+ */
+int UdpNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue) {
+	int id = myaddr->getId();
+	int time = par->getcurrtime();
+
+	if ( lastPoll != time ) {
+		pollReady();
+		lastPoll = time;
+	}
+	if ( sockets[id] < 0 || !ready[id] ) {
+		return 0;
+	}
+	ready[id] = false;
+
+	int n;
+	do {
+		for ( int i = 0; i < UDP_BATCH; i++ ) {
+			iovs[i].iov_base = spare[i];
+			iovs[i].iov_len = par->MAX_MSG_SIZE;
+			memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		syscalls++;
+		n = recvmmsg(sockets[id], msgs, UDP_BATCH, MSG_DONTWAIT, NULL);
+		for ( int i = 0; i < n; i++ ) {
+			(*enq)(queue, spare[i], msgs[i].msg_len);
+			spare[i] = (char *)pool.alloc(par->MAX_MSG_SIZE);
+			countMsg(recv_msgs, id, time);
+			totalRecv++;
+		}
+	} while ( n == UDP_BATCH );
+
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: ENrelease
+ *
+ * DESCRIPTION: Return a buffer received through ENrecv to the pool
+ */
+void UdpNet::ENrelease(char *data) {
+	pool.release(data);
+}
+
+/**
+ * FUNCTION NAME: ENmaxPayload
+ *
+ * DESCRIPTION: Largest datagram ENsend accepts under MAX_MSG_SIZE, and that UDP can carry
+ */
+int UdpNet::ENmaxPayload() {
+	return min(par->MAX_MSG_SIZE - 1, UDP_MAX_DATAGRAM);
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Close every socket and write msgcount.log. Called once at the end of the program.
+ */
+int UdpNet::ENcleanup() {
+	bool open = false;
+	for ( int &fd : sockets ) {
+		if ( fd >= 0 ) {
+			close(fd);
+			fd = -1;
+			open = true;
+		}
+	}
+	if ( open ) {
+		writeMsgCount(par);
+	}
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: getTotalSent
+ *
+ * DESCRIPTION: Number of datagrams handed to the kernel so far
+ */
+long UdpNet::getTotalSent() {
+	return totalSent;
+}
+
+/**
+ * FUNCTION NAME: getTotalRecv
+ *
+ * DESCRIPTION: Number of datagrams handed out by ENrecv so far
+ */
+long UdpNet::getTotalRecv() {
+	return totalRecv;
+}
+
+/**
+ * FUNCTION NAME: getTotalBytes
+ *
+ * DESCRIPTION: Payload bytes handed to the kernel so far
+ */
+long UdpNet::getTotalBytes() {
+	return totalBytes;
+}
+
+/**
+ * FUNCTION NAME: getOverflowDrops
+ *
+ * DESCRIPTION: Number of datagrams the kernel refused to send
+ */
+long UdpNet::getOverflowDrops() {
+	return sendErrors;
+}
+
+/**
+ * FUNCTION NAME: getOversizeDrops
+ *
+ * DESCRIPTION: Number of messages refused because they exceed MAX_MSG_SIZE
+ */
+long UdpNet::getOversizeDrops() {
+	return oversizeDrops;
+}
+
+/**
+ * FUNCTION NAME: getSyscalls
+ *
+ * DESCRIPTION: Number of socket and epoll system calls made so far
+ */
+long UdpNet::getSyscalls() {
+	return syscalls;
+}
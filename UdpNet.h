@@ -0,0 +1,88 @@
+/**********************************
+ * FILE NAME: UdpNet.h
+ *
+ * DESCRIPTION: Loopback UDP transport header file
+ **********************************/
+
+#ifndef _UDPNET_H_
+#define _UDPNET_H_
+
+#include "stdincludes.h"
+#include "Params.h"
+#include "Member.h"
+#include "BufferPool.h"
+#include "Transport.h"
+
+/*
+ * Macros
+ */
+// datagrams moved per sendmmsg/recvmmsg call
+#define UDP_BATCH 64
+// largest UDP payload over IPv4
+#define UDP_MAX_DATAGRAM 65507
+// receive buffer asked for on every socket; the kernel caps it at rmem_max
+#define UDP_RCVBUF (4 * 1024 * 1024)
+
+/**
+ * CLASS NAME: UdpNet
+ *
+ * DESCRIPTION: Transport over real sockets. Every node gets its own UDP socket
+ * 				bound to 127.0.0.1:UDP_BASE_PORT + id. Readiness comes from one
+ * 				epoll set, polled once per time unit, so only nodes with pending
+ * 				datagrams pay for a receive call. Receives and batched sends go
+ * 				through recvmmsg/sendmmsg, UDP_BATCH datagrams at a time.
+ * 				Random drops follow DROP_MSG as in EmulNet; datagrams the kernel
+ * 				loses on a full socket buffer show up as sent but not received.
+ * 				Every socket related system call is counted. Not thread-safe:
+ * 				runs with THREADS: 1.
+ */
+class UdpNet: public Transport {
+private:
+	Params *par;
+	int nextid;
+	int epfd;
+	// socket of every node id, -1 if it could not be opened
+	vector<int> sockets;
+	// node ids epoll found readable in the current time unit
+	vector<bool> ready;
+	int lastPoll;
+	vector<struct epoll_event> events;
+	vector<minstd_rand> dropRng;
+	BufferPool pool;
+	// receive buffers handed to the next recvmmsg
+	char *spare[UDP_BATCH];
+	struct mmsghdr msgs[UDP_BATCH];
+	struct iovec iovs[UDP_BATCH];
+	struct sockaddr_in dests[UDP_BATCH];
+	long totalSent;
+	long totalRecv;
+	long totalBytes;
+	// datagrams the kernel refused to send
+	long sendErrors;
+	long oversizeDrops;
+	long syscalls;
+	UdpNet(const UdpNet &anotherUdpNet);
+	UdpNet& operator =(const UdpNet &anotherUdpNet);
+	bool accept(Address *myaddr, int size);
+	void setDest(struct sockaddr_in *dest, Address *toaddr);
+	void counted(Address *myaddr, int size);
+	void pollReady();
+public:
+	UdpNet(Params *p);
+	virtual ~UdpNet();
+	void *ENinit(Address *myaddr, short port);
+	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
+	int ENsendBatch(Address *myaddr, Address *toaddrs, int count, char *data, int size);
+	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
+	void ENrelease(char *data);
+	int ENmaxPayload();
+	int ENcleanup();
+	long getTotalSent();
+	long getTotalRecv();
+	long getTotalBytes();
+	long getOverflowDrops();
+	long getOversizeDrops();
+	long getSyscalls();
+};
+
+#endif /* _UDPNET_H_ */